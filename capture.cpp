@@ -0,0 +1,766 @@
+/*
+Program: ESPFileXfer
+File: capture.cpp
+Author: Listerine-debug
+Description: This file contains the implementation of binary session capture and replay
+for ESPFileXfer.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+#include "capture.h"
+#include "deviceprotocol.h"
+#include "stdexcept"
+#include "algorithm"
+
+using asio::ip::tcp;
+
+static const char captureMagic[6] = { 'E', 'S', 'P', 'C', 'A', 'P' };
+static constexpr uint8_t CAPTURE_VERSION = 0x03;
+
+static void writeVarint(std::ostream& out, uint64_t value)
+{
+	char bytes[10];
+	int count = 0;
+	do
+	{
+		uint8_t byte = value & 0x7F;
+		value >>= 7;
+		if (value) byte |= 0x80;
+		bytes[count++] = static_cast<char>(byte);
+	} while (value);
+	out.write(bytes, count);
+}
+
+static bool readVarint(std::istream& in, uint64_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		int byte = in.get();
+		if (byte == EOF) return false;
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) return true;
+	}
+	return false;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------------------ */
+
+bool sessionRecorder::open(const std::string& path, captureTransport transport)
+{
+	std::lock_guard<std::mutex> lock(recordMutex);
+	captureFile.open(path, std::ios::binary | std::ios::trunc);
+	if (!captureFile) return false;
+
+	uint64_t wallClockNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	char header[17];
+	std::copy(captureMagic, captureMagic + 6, header);
+	header[6] = 0x00;
+	header[7] = static_cast<char>(CAPTURE_VERSION);
+	for (int i = 0; i < 8; ++i)
+		header[8 + i] = static_cast<char>((wallClockNs >> (8 * i)) & 0xFF);
+	header[16] = static_cast<char>(transport);
+	captureFile.write(header, sizeof(header));
+
+	startTime = std::chrono::steady_clock::now();
+	lastTimestampNs = 0;
+	lastStream = 0;
+	active = true;
+	return true;
+}
+
+void sessionRecorder::close()
+{
+	std::lock_guard<std::mutex> lock(recordMutex);
+	active = false;
+	if (captureFile.is_open())
+	{
+		captureFile.flush();
+		captureFile.close();
+	}
+}
+
+void sessionRecorder::record(captureDirection direction, const char* data, std::size_t len, uint32_t stream)
+{
+	if (!active || len == 0) return;
+
+	// Timestamp before taking the lock so contention does not skew the capture
+	uint64_t timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - startTime).count();
+
+	std::lock_guard<std::mutex> lock(recordMutex);
+	if (!captureFile.is_open()) return;
+
+	// Reads and writes come from different threads, keep deltas non-negative
+	if (timestampNs < lastTimestampNs) timestampNs = lastTimestampNs;
+
+	captureFile.put(static_cast<char>(direction));
+	writeVarint(captureFile, stream);
+	writeVarint(captureFile, timestampNs - lastTimestampNs);
+	writeVarint(captureFile, len);
+	captureFile.write(data, len);
+	lastTimestampNs = timestampNs;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------------------ */
+
+bool sessionReader::open(const std::string& path)
+{
+	captureFile.open(path, std::ios::binary);
+	if (!captureFile) return false;
+
+	char header[16];
+	if (!captureFile.read(header, sizeof(header))) return false;
+	if (!std::equal(captureMagic, captureMagic + 6, header) || header[6] != 0x00) return false;
+
+	version = static_cast<uint8_t>(header[7]);
+	if (version < 0x01 || version > CAPTURE_VERSION) return false;
+
+	fileTransport = captureTransport::UNKNOWN;
+	if (version >= 0x02)
+	{
+		int transport = captureFile.get();
+		if (transport != static_cast<int>(captureTransport::SERIAL) && transport != static_cast<int>(captureTransport::WIFI))
+			return false;
+		fileTransport = static_cast<captureTransport>(transport);
+	}
+
+	timestampNs = 0;
+	corrupt = false;
+	return true;
+}
+
+bool sessionReader::next(captureRecord& record)
+{
+	int direction = captureFile.get();
+	if (direction == EOF) return false;
+
+	corrupt = true;
+	if (direction != static_cast<int>(captureDirection::READ) && direction != static_cast<int>(captureDirection::WRITE))
+		return false;
+
+	uint64_t stream = 0;
+	uint64_t deltaNs = 0;
+	uint64_t len = 0;
+	if (version >= 0x03 && (!readVarint(captureFile, stream) || stream > UINT32_MAX)) return false;
+	if (!readVarint(captureFile, deltaNs) || !readVarint(captureFile, len)) return false;
+
+	timestampNs += deltaNs;
+	record.timestampNs = timestampNs;
+	record.stream = static_cast<uint32_t>(stream);
+	record.direction = static_cast<captureDirection>(direction);
+	record.data.resize(static_cast<std::size_t>(len));
+	if (len > 0 && !captureFile.read(&record.data[0], len)) return false;
+
+	corrupt = false;
+	return true;
+}
+
+bool sessionReader::load(const std::string& path, std::vector<captureRecord>& records,
+	captureTransport& transport, std::string& error)
+{
+	sessionReader reader;
+	if (!reader.open(path))
+	{
+		error = "Not a session capture: " + path;
+		return false;
+	}
+
+	records.clear();
+	captureRecord record;
+	while (reader.next(record))
+		records.push_back(record);
+
+	if (reader.damaged())
+	{
+		error = "Capture is damaged after record " + std::to_string(records.size()) + ": " + path;
+		return false;
+	}
+	transport = reader.transport();
+	return true;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------------------ */
+
+recordedDevice::recordedDevice(const std::vector<captureRecord>& records)
+{
+	std::map<uint32_t, std::vector<const captureRecord*>> streams;
+	for (const captureRecord& record : records)
+	{
+		if (record.stream != 0)
+			streams[record.stream].push_back(&record);
+	}
+
+	replyTiming timing;
+	std::vector<streamSummary> summaries;
+	for (const auto& stream : streams)
+		summaries.push_back(parseStream(stream.second, timing));
+
+	if (timing.latencyCount > 0)
+		averagePace.latencyNs = timing.latencyNs / timing.latencyCount;
+	if (timing.rangeBytes > 0)
+		averagePace.nsPerByte = static_cast<double>(timing.rangeNs) / timing.rangeBytes;
+	streamClaimed.assign(streams.size(), false);
+
+	// parallelDownloader asks for the size on a connection of its own, then opens the range streams
+	for (const streamSummary& summary : summaries)
+	{
+		if (!summary.sizePath.empty() && summary.rangePath.empty())
+			recordedDownloads.push_back({ summary.sizePath, 1, 0, summary.firstNs, summary.lastNs });
+	}
+	std::sort(recordedDownloads.begin(), recordedDownloads.end(),
+		[](const download& a, const download& b) { return a.startNs < b.startNs; });
+
+	std::vector<std::vector<std::pair<uint64_t, int>>> streamEdges(recordedDownloads.size());
+	for (const streamSummary& summary : summaries)
+	{
+		if (summary.rangePath.empty()) continue;
+
+		// Belongs to the latest download of the same file that started before it
+		for (std::size_t i = recordedDownloads.size(); i-- > 0;)
+		{
+			download& owner = recordedDownloads[i];
+			if (owner.path != summary.rangePath || owner.startNs > summary.firstNs) continue;
+
+			owner.endNs = std::max(owner.endNs, summary.lastNs);
+			owner.chunkSize = std::max(owner.chunkSize, summary.largestRange);
+			streamEdges[i].push_back({ summary.firstNs, 1 });
+			streamEdges[i].push_back({ summary.lastNs, -1 });
+			break;
+		}
+	}
+
+	// Reconnects open extra streams, what matters is how many ran side by side
+	for (std::size_t i = 0; i < recordedDownloads.size(); ++i)
+	{
+		std::sort(streamEdges[i].begin(), streamEdges[i].end(),
+			[](const std::pair<uint64_t, int>& a, const std::pair<uint64_t, int>& b)
+			{
+				return a.first != b.first ? a.first < b.first : a.second < b.second;
+			});
+		int open = 0;
+		for (const auto& edge : streamEdges[i])
+		{
+			open += edge.second;
+			recordedDownloads[i].connections = std::max(recordedDownloads[i].connections, static_cast<unsigned>(std::max(open, 1)));
+		}
+	}
+}
+
+recordedDevice::streamSummary recordedDevice::parseStream(const std::vector<const captureRecord*>& streamRecords, replyTiming& timing)
+{
+	streamSummary summary;
+	if (streamRecords.empty()) return summary;
+	summary.firstNs = streamRecords.front()->timestampNs;
+	summary.lastNs = streamRecords.back()->timestampNs;
+
+	// Each direction as one byte stream, with the time the record holding each byte was taken
+	std::string sent;
+	std::string received;
+	std::vector<std::pair<std::size_t, uint64_t>> sentEnds;
+	std::vector<std::pair<std::size_t, uint64_t>> receivedEnds;
+	for (const captureRecord* record : streamRecords)
+	{
+		bool isWrite = record->direction == captureDirection::WRITE;
+		std::string& bytes = isWrite ? sent : received;
+		bytes += record->data;
+		(isWrite ? sentEnds : receivedEnds).push_back({ bytes.size(), record->timestampNs });
+	}
+	auto timeAt = [](const std::vector<std::pair<std::size_t, uint64_t>>& ends, std::size_t offset)
+		{
+			auto end = std::upper_bound(ends.begin(), ends.end(), std::make_pair(offset, UINT64_MAX));
+			return end == ends.end() ? ends.back().second : end->second;
+		};
+
+	recordedStream stream;
+	auto addReply = [&stream](uint8_t command, const std::string& path, const replyPace& pace)
+		{
+			if (command == deviceProtocol::HANDSHAKE) return;
+			if (stream.replies.empty())
+			{
+				stream.command = command;
+				stream.path = path;
+			}
+			stream.replies.push_back(pace);
+		};
+
+	std::size_t in = 0;
+	std::size_t out = 0;
+	while (in < sent.size())
+	{
+		uint8_t command = static_cast<uint8_t>(sent[in++]);
+		std::string path;
+		uint32_t offset = 0;
+		uint32_t length = 0;
+
+		if (command == deviceProtocol::FILE_SIZE || command == deviceProtocol::FILE_RANGE)
+		{
+			if (in + 2 > sent.size()) break;
+			std::size_t pathLength = deviceProtocol::getLittleEndian(&sent[in], 2);
+			in += 2;
+			if (in + pathLength > sent.size()) break;
+			path = sent.substr(in, pathLength);
+			in += pathLength;
+
+			if (command == deviceProtocol::FILE_RANGE)
+			{
+				if (in + 8 > sent.size()) break;
+				offset = deviceProtocol::getLittleEndian(&sent[in], 4);
+				length = deviceProtocol::getLittleEndian(&sent[in + 4], 4);
+				in += 8;
+			}
+		}
+		else if (command != deviceProtocol::HANDSHAKE && command != deviceProtocol::CAPABILITIES)
+			break;	// deviceLink downloads send nothing else
+
+		// A request without a complete reply is where the host timed out and dropped the stream
+		replyPace pace;
+		pace.answered = false;
+		if (out >= received.size())
+		{
+			addReply(command, path, pace);
+			break;
+		}
+
+		uint64_t requestNs = timeAt(sentEnds, in - 1);
+		uint64_t replyNs = timeAt(receivedEnds, out);
+		pace.latencyNs = replyNs > requestNs ? replyNs - requestNs : 0;
+		bool succeeded = static_cast<uint8_t>(received[out++]) == deviceProtocol::SUCCESS;
+
+		if (command == deviceProtocol::CAPABILITIES)
+		{
+			capabilitiesSupported = succeeded && out < received.size();
+			if (capabilitiesSupported)
+				capabilities = static_cast<uint8_t>(received[out++]);
+		}
+		else if (command == deviceProtocol::FILE_SIZE && succeeded)
+		{
+			if (out + 4 > received.size())
+			{
+				addReply(command, path, pace);
+				break;
+			}
+			remoteFile& file = files[path];
+			file.data.resize(deviceProtocol::getLittleEndian(&received[out], 4));
+			file.served.resize(file.data.size());
+			file.sizeKnown = true;
+			out += 4;
+			summary.sizePath = path;
+		}
+		else if (command == deviceProtocol::FILE_RANGE && succeeded)
+		{
+			if (length == 0 || out + length > received.size())
+			{
+				addReply(command, path, pace);
+				break;
+			}
+			remoteFile& file = files[path];
+			if (file.data.size() < static_cast<uint64_t>(offset) + length)
+			{
+				file.data.resize(static_cast<std::size_t>(offset) + length);
+				file.served.resize(file.data.size());
+			}
+			std::copy(received.begin() + out, received.begin() + out + length, file.data.begin() + offset);
+			std::fill(file.served.begin() + offset, file.served.begin() + offset + length, true);
+
+			uint64_t dataNs = timeAt(receivedEnds, out + length - 1);
+			uint64_t dataTimeNs = dataNs > replyNs ? dataNs - replyNs : 0;
+			pace.nsPerByte = static_cast<double>(dataTimeNs) / length;
+			timing.rangeNs += dataTimeNs;
+			timing.rangeBytes += length;
+			out += length;
+			summary.rangePath = path;
+			summary.largestRange = std::max(summary.largestRange, length);
+		}
+
+		pace.answered = true;
+		timing.latencyNs += pace.latencyNs;
+		++timing.latencyCount;
+		addReply(command, path, pace);
+	}
+
+	if (!stream.replies.empty())
+		streams.push_back(stream);
+	return summary;
+}
+
+const recordedDevice::recordedStream* recordedDevice::claimStream(uint8_t command, const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(claimMutex);
+	for (std::size_t i = 0; i < streams.size(); ++i)
+	{
+		if (!streamClaimed[i] && streams[i].command == command && streams[i].path == path)
+		{
+			streamClaimed[i] = true;
+			return &streams[i];
+		}
+	}
+	return nullptr;
+}
+
+bool recordedDevice::fileContent(const std::string& path, std::string& content) const
+{
+	auto file = files.find(path);
+	if (file == files.end() || !file->second.sizeKnown) return false;
+	if (std::find(file->second.served.begin(), file->second.served.end(), false) != file->second.served.end())
+		return false;
+
+	content = file->second.data;
+	return true;
+}
+
+void recordedDevice::serve(tcp::socket& socket, double speed, const std::function<void()>& onRequest)
+{
+	auto readPath = [&socket]()
+		{
+			char length[2];
+			asio::read(socket, asio::buffer(length, sizeof(length)));
+			std::string path(deviceProtocol::getLittleEndian(length, 2), '\0');
+			if (!path.empty())
+				asio::read(socket, asio::buffer(&path[0], path.size()));
+			return path;
+		};
+	const char failure = static_cast<char>(deviceProtocol::FAILURE);
+	const recordedStream* pattern = nullptr;
+	std::size_t replyIndex = 0;
+
+	for (;;)
+	{
+		char command = 0;
+		asio::error_code error;
+		asio::read(socket, asio::buffer(&command, 1), error);
+		if (error) return;
+		onRequest();
+
+		uint8_t request = static_cast<uint8_t>(command);
+		std::string path;
+		char args[8];
+		std::size_t argsLength = 0;
+		switch (request)
+		{
+		case deviceProtocol::HANDSHAKE:
+		case deviceProtocol::CAPABILITIES:
+			break;
+		case deviceProtocol::FILE_SIZE:
+			path = readPath();
+			break;
+		case deviceProtocol::FILE_RANGE:
+			path = readPath();
+			argsLength = 8;
+			break;
+		case deviceProtocol::LIST_DIRECTORY:
+			path = readPath();
+			argsLength = 6;
+			break;
+		case deviceProtocol::PAGE_CHECKSUMS:
+			path = readPath();
+			argsLength = 1;
+			break;
+		case deviceProtocol::RPC:
+			argsLength = 6;
+			break;
+		default:
+			return;	// cannot tell where the request ends, nothing sensible to answer
+		}
+		if (argsLength > 0)
+			asio::read(socket, asio::buffer(args, argsLength));
+
+		std::string rpcText;
+		if (request == deviceProtocol::RPC)
+		{
+			rpcText.resize(deviceProtocol::getLittleEndian(args + 4, 2));
+			if (!rpcText.empty())
+				asio::read(socket, asio::buffer(&rpcText[0], rpcText.size()));
+		}
+
+		if (!pattern && request != deviceProtocol::HANDSHAKE)
+			pattern = claimStream(request, path);
+		replyPace pace = averagePace;
+		if (pattern)
+		{
+			if (replyIndex < pattern->replies.size())
+				pace = pattern->replies[replyIndex];
+			++replyIndex;
+		}
+
+		if (!pace.answered)
+		{
+			// The device went quiet here in the recording, stay quiet until the host gives up
+			char drain[128];
+			while (!error)
+				socket.read_some(asio::buffer(drain), error);
+			return;
+		}
+		if (speed > 0)
+			std::this_thread::sleep_for(std::chrono::nanoseconds(static_cast<uint64_t>(pace.latencyNs / speed)));
+
+		switch (request)
+		{
+		case deviceProtocol::HANDSHAKE:
+		{
+			asio::write(socket, asio::buffer(&command, 1));
+			break;
+		}
+		case deviceProtocol::CAPABILITIES:
+		{
+			char reply[2] = { static_cast<char>(deviceProtocol::SUCCESS), static_cast<char>(capabilities) };
+			if (capabilitiesSupported)
+				asio::write(socket, asio::buffer(reply, sizeof(reply)));
+			else
+				asio::write(socket, asio::buffer(&failure, 1));
+			break;
+		}
+		case deviceProtocol::FILE_SIZE:
+		{
+			auto file = files.find(path);
+			if (file == files.end() || !file->second.sizeKnown)
+			{
+				asio::write(socket, asio::buffer(&failure, 1));
+				break;
+			}
+			char reply[5] = { static_cast<char>(deviceProtocol::SUCCESS) };
+			deviceProtocol::putLittleEndian(reply + 1, file->second.data.size(), 4);
+			asio::write(socket, asio::buffer(reply, sizeof(reply)));
+			break;
+		}
+		case deviceProtocol::FILE_RANGE:
+		{
+			uint64_t offset = deviceProtocol::getLittleEndian(args, 4);
+			uint64_t length = deviceProtocol::getLittleEndian(args + 4, 4);
+
+			// Only bytes the device actually sent in the recording can be served
+			auto file = files.find(path);
+			bool available = file != files.end() && offset + length <= file->second.data.size()
+				&& std::find(file->second.served.begin() + offset, file->second.served.begin() + offset + length, false)
+					== file->second.served.begin() + offset + length;
+			if (!available)
+			{
+				asio::write(socket, asio::buffer(&failure, 1));
+				break;
+			}
+
+			char success = static_cast<char>(deviceProtocol::SUCCESS);
+			asio::write(socket, asio::buffer(&success, 1));
+
+			// Paced against the start of the reply so per piece sleeps do not add up
+			auto replyStart = std::chrono::steady_clock::now();
+			for (uint64_t sent = 0; sent < length;)
+			{
+				uint64_t piece = std::min<uint64_t>(length - sent, 4096);
+				if (speed > 0)
+					std::this_thread::sleep_until(replyStart + std::chrono::nanoseconds(static_cast<uint64_t>((sent + piece) * pace.nsPerByte / speed)));
+				asio::write(socket, asio::buffer(file->second.data.data() + offset + sent, static_cast<std::size_t>(piece)));
+				sent += piece;
+			}
+			break;
+		}
+		case deviceProtocol::RPC:
+		{
+			const std::string reason = "Not in the capture";
+			std::string reply(8, '\0');
+			reply[0] = command;
+			std::copy(args, args + 4, reply.begin() + 1);
+			reply[5] = failure;
+			deviceProtocol::putLittleEndian(&reply[6], reason.size(), 2);
+			asio::write(socket, asio::buffer(reply + reason));
+			break;
+		}
+		default:
+		{
+			// Directory contents are not in a capture
+			asio::write(socket, asio::buffer(&failure, 1));
+			break;
+		}
+		}
+	}
+}
+
+/* ------------------------------------------------------------------------------------------------------------------------------ */
+
+sessionReplayServer::sessionReplayServer(const std::string& capturePath, double speed)
+	: path(capturePath), playbackSpeed(speed)
+{
+}
+
+unsigned short sessionReplayServer::start(std::function<void(const replayResult& result)> onFinished)
+{
+	captureTransport transport = captureTransport::UNKNOWN;
+	std::string error;
+	if (!sessionReader::load(path, records, transport, error))
+		throw std::runtime_error(error);
+	if (transport == captureTransport::SERIAL)
+		throw std::runtime_error("Serial captures cannot be replayed through the WiFi stack");
+
+	device = std::make_unique<recordedDevice>(records);
+	finishedCallback = onFinished;
+
+	tcp::endpoint endpoint(asio::ip::make_address("127.0.0.1"), 0);
+	acceptor.open(endpoint.protocol());
+	acceptor.bind(endpoint);
+	acceptor.listen(asio::socket_base::max_listen_connections);
+
+	auto self = shared_from_this();
+	std::thread([self]() { self->run(); }).detach();
+
+	return acceptor.local_endpoint().port();
+}
+
+void sessionReplayServer::hostWrote()
+{
+	std::lock_guard<std::mutex> lock(clockMutex);
+	if (!started)
+	{
+		started = true;
+		startTime = std::chrono::steady_clock::now();
+	}
+}
+
+void sessionReplayServer::acceptStreams()
+{
+	while (!stopping)
+	{
+		auto socket = std::make_shared<tcp::socket>(ioContext);
+		asio::error_code error;
+		acceptor.accept(*socket, error);
+		if (error || stopping) return;
+		socket->set_option(tcp::no_delay(true), error);
+
+		std::lock_guard<std::mutex> lock(streamMutex);
+		streamSockets.push_back(socket);
+		streamThreads.emplace_back([this, socket]()
+			{
+				try
+				{
+					device->serve(*socket, playbackSpeed, [this]() { hostWrote(); });
+				}
+				catch (const std::exception&)
+				{
+					// Host dropped the connection mid request
+				}
+				std::lock_guard<std::mutex> lock(streamMutex);
+				asio::error_code ignored;
+				socket->close(ignored);
+			});
+	}
+}
+
+void sessionReplayServer::run()
+{
+	replayResult result;
+	tcp::socket socket(ioContext);
+	try
+	{
+		acceptor.accept(socket);
+		socket.set_option(tcp::no_delay(true));
+	}
+	catch (const std::exception& e)
+	{
+		result.error = std::string("No host connected: ") + e.what();
+		if (finishedCallback) finishedCallback(result);
+		return;
+	}
+	auto acceptTime = std::chrono::steady_clock::now();
+
+	// Every later connection is a deviceLink stream, answered by the recorded device
+	std::thread acceptThread(&sessionReplayServer::acceptStreams, this);
+
+	try
+	{
+		std::string received;
+
+		// Device reads are paced against an anchor rather than per record sleeps so drift does
+		// not accumulate. Each host write moves the anchor, so a host that answers late shifts
+		// what follows instead of releasing it in one burst. Until the host writes, the clock
+		// has not started and nothing before that point counts towards the replay.
+		auto anchorTime = acceptTime;
+		uint64_t anchorNs = 0;
+
+		for (std::size_t recordIndex = 0; recordIndex < records.size(); ++recordIndex)
+		{
+			const captureRecord& record = records[recordIndex];
+			if (record.stream != 0) continue;
+
+			auto due = anchorTime;
+			if (playbackSpeed > 0 && record.timestampNs > anchorNs)
+				due += std::chrono::nanoseconds(static_cast<uint64_t>((record.timestampNs - anchorNs) / playbackSpeed));
+
+			if (record.direction == captureDirection::READ)
+			{
+				std::this_thread::sleep_until(due);
+				asio::write(socket, asio::buffer(record.data));
+			}
+			else
+			{
+				// The host must send what it sent in the original session, anything else
+				// means it took a different path and the timing would be meaningless
+				received.resize(record.data.size());
+				asio::read(socket, asio::buffer(&received[0], received.size()));
+				if (received != record.data)
+				{
+					result.error = "Host write " + std::to_string(recordIndex) + " differs from the capture";
+					break;
+				}
+
+				hostWrote();
+				anchorTime = std::chrono::steady_clock::now();
+				anchorNs = record.timestampNs;
+			}
+		}
+
+		// The host is done once it has dealt with the last bytes and closes the connection
+		if (result.error.empty())
+		{
+			char drain[128];
+			asio::error_code error;
+			while (!error)
+				socket.read_some(asio::buffer(drain), error);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		result.error = std::string("Host disconnected mid replay: ") + e.what();
+	}
+	auto endTime = std::chrono::steady_clock::now();
+
+	// Wake the accept loop with a connection of our own, then cut off streams the host left open
+	stopping = true;
+	try
+	{
+		tcp::socket wake(ioContext);
+		wake.connect(acceptor.local_endpoint());
+	}
+	catch (const std::exception&)
+	{
+	}
+	acceptThread.join();
+	{
+		std::lock_guard<std::mutex> lock(streamMutex);
+		for (auto& streamSocket : streamSockets)
+		{
+			asio::error_code ignored;
+			streamSocket->shutdown(tcp::socket::shutdown_both, ignored);
+		}
+	}
+	for (auto& streamThread : streamThreads)
+		streamThread.join();
+	asio::error_code ignored;
+	acceptor.close(ignored);
+
+	if (result.error.empty())
+	{
+		uint64_t firstWriteNs = 0;
+		auto firstWrite = std::find_if(records.begin(), records.end(),
+			[](const captureRecord& record) { return record.direction == captureDirection::WRITE; });
+		if (firstWrite != records.end())
+			firstWriteNs = firstWrite->timestampNs;
+
+		std::lock_guard<std::mutex> lock(clockMutex);
+		result.replayNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			endTime - (started ? startTime : acceptTime)).count();
+		result.recordedNs = records.empty() ? 0 : records.back().timestampNs - firstWriteNs;
+	}
+
+	if (finishedCallback) finishedCallback(result);
+}
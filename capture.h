@@ -0,0 +1,226 @@
+/*
+Program: ESPFileXfer
+File: capture.h
+Author: Listerine-debug
+Description: This file contains the declarations for binary session capture and replay,
+used to record serial/WiFi sessions with nanosecond timestamps and play them back
+through the host stack as repeatable benchmarks.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+
+#ifndef _CAPTURE_H_
+#define _CAPTURE_H_
+
+#include "asio.hpp"
+#include "string"
+#include "fstream"
+#include "mutex"
+#include "atomic"
+#include "chrono"
+#include "functional"
+#include "memory"
+#include "thread"
+#include "vector"
+#include "map"
+#include "cstdint"
+
+// Capture file layout:
+//   header : "ESPCAP" 0x00 0x03, uint64 wall clock start (ns since epoch, little endian),
+//            uint8 transport (version 0x01 files have no transport byte and read as UNKNOWN)
+//   record : uint8 direction, varint stream, varint delta ns since previous record, varint length, data
+//            (versions before 0x03 have no stream and read as stream 0)
+// Stream 0 is the window's own socket, every deviceLink connection made while recording gets
+// the next stream id, so Parallel Extract shows up as one stream per connection.
+enum class captureTransport : uint8_t
+{
+	SERIAL = 0x00,	// recorded from a serialFrame
+	WIFI = 0x01,	// recorded from a wifiSerialFrame
+	UNKNOWN = 0xFF
+};
+
+enum class captureDirection : uint8_t
+{
+	READ = 0x00,	// bytes received from the device
+	WRITE = 0x01	// bytes sent to the device
+};
+
+struct captureRecord
+{
+	uint64_t timestampNs = 0;	// since start of capture
+	uint32_t stream = 0;
+	captureDirection direction = captureDirection::READ;
+	std::string data;
+};
+
+class sessionRecorder
+{
+public:
+	bool open(const std::string& path, captureTransport transport);
+	void close();
+	bool isOpen() const { return active; }
+	void record(captureDirection direction, const char* data, std::size_t len, uint32_t stream = 0);
+	// Id for a new connection next to the window's socket, unique within one capture
+	uint32_t newStream() { return ++lastStream; }
+
+private:
+	std::mutex recordMutex;
+	std::ofstream captureFile;
+	std::chrono::steady_clock::time_point startTime;
+	uint64_t lastTimestampNs = 0;
+	std::atomic<uint32_t> lastStream = 0;
+	std::atomic<bool> active = false;
+};
+
+class sessionReader
+{
+public:
+	bool open(const std::string& path);
+	bool next(captureRecord& record);
+	captureTransport transport() const { return fileTransport; }
+	// True when next() stopped on a damaged record rather than the end of the file
+	bool damaged() const { return corrupt; }
+
+	// Reads a whole capture, false with the reason when the file is not a complete capture
+	static bool load(const std::string& path, std::vector<captureRecord>& records,
+		captureTransport& transport, std::string& error);
+
+private:
+	std::ifstream captureFile;
+	uint64_t timestampNs = 0;
+	captureTransport fileTransport = captureTransport::UNKNOWN;
+	uint8_t version = 0;
+	bool corrupt = false;
+};
+
+// The device side of every deviceLink stream in a capture, rebuilt into file sizes, file
+// contents and response times. The host's parallel downloads split ranges differently on
+// every run, so these streams are answered from this model instead of byte for byte.
+class recordedDevice
+{
+public:
+	// One Parallel Extract: the FILE_SIZE stream and the range streams that followed it
+	struct download
+	{
+		std::string path;
+		unsigned connections = 1;	// most range streams open at once
+		uint32_t chunkSize = 0;		// largest range requested
+		uint64_t startNs = 0;
+		uint64_t endNs = 0;
+	};
+
+	explicit recordedDevice(const std::vector<captureRecord>& records);
+
+	const std::vector<download>& downloads() const { return recordedDownloads; }
+	// False unless every byte of the file was served in the capture
+	bool fileContent(const std::string& path, std::string& content) const;
+
+	// Answers requests on a connected socket until the host closes it, pacing replies like
+	// the recording at the given speed. onRequest runs as each request arrives.
+	void serve(asio::ip::tcp::socket& socket, double speed, const std::function<void()>& onRequest);
+
+private:
+	// How the device answered one request in the recording
+	struct replyPace
+	{
+		uint64_t latencyNs = 0;		// request to first reply byte
+		double nsPerByte = 0;		// range data after the first reply byte
+		bool answered = true;		// false where the device went quiet until the host gave up
+	};
+
+	// Requests of one recorded stream after its handshake. A new connection replays the
+	// timing of the first unclaimed stream that opened with the same request, so slow and
+	// stalled connections in the recording stay slow and stalled in the replay.
+	struct recordedStream
+	{
+		uint8_t command = 0;
+		std::string path;
+		std::vector<replyPace> replies;
+	};
+
+	struct remoteFile
+	{
+		bool sizeKnown = false;
+		std::string data;
+		std::vector<bool> served;
+	};
+
+	struct streamSummary
+	{
+		uint64_t firstNs = 0;
+		uint64_t lastNs = 0;
+		std::string sizePath;	// FILE_SIZE asked on this stream
+		std::string rangePath;	// FILE_RANGE asked on this stream
+		uint32_t largestRange = 0;
+	};
+
+	struct replyTiming
+	{
+		uint64_t latencyNs = 0;
+		uint64_t latencyCount = 0;
+		uint64_t rangeNs = 0;
+		uint64_t rangeBytes = 0;
+	};
+
+	streamSummary parseStream(const std::vector<const captureRecord*>& streamRecords, replyTiming& timing);
+	const recordedStream* claimStream(uint8_t command, const std::string& path);
+
+	std::map<std::string, remoteFile> files;
+	std::vector<download> recordedDownloads;
+	std::vector<recordedStream> streams;
+	std::vector<bool> streamClaimed;
+	std::mutex claimMutex;
+	replyPace averagePace;			// for connections and requests the recording has no match for
+	bool capabilitiesSupported = false;	// FAILURE is what firmware without the query answers
+	uint8_t capabilities = 0;
+};
+
+struct replayResult
+{
+	uint64_t replayNs = 0;		// first host write until the host closed the window's connection
+	uint64_t recordedNs = 0;	// first host write until the last record of the capture
+	std::string error;			// empty when the host sent exactly what the capture holds
+};
+
+// Plays the device side of a capture on a loopback TCP port so a regular
+// wifiSerialFrame can connect to it and run the real host code paths. The first
+// connection gets stream 0 back exactly as recorded, later ones (Parallel Extract,
+// the SD browser) are answered by a recordedDevice.
+class sessionReplayServer : public std::enable_shared_from_this<sessionReplayServer>
+{
+public:
+	// speed: 1.0 = original timing, 10.0 = ten times faster, 0 = as fast as possible
+	sessionReplayServer(const std::string& capturePath, double speed);
+
+	// Loads the capture, binds 127.0.0.1 on an ephemeral port and starts serving in the
+	// background. Throws when the file is not a complete capture or was recorded over
+	// serial, which this server cannot stand in for. onFinished runs once the host has
+	// closed the first connection or sent something stream 0 does not hold. Timing starts
+	// at the first host write, so a session that waited on a person is not charged for it.
+	unsigned short start(std::function<void(const replayResult& result)> onFinished);
+
+private:
+	void run();
+	void acceptStreams();
+	void hostWrote();
+
+	std::string path;
+	std::vector<captureRecord> records;
+	std::unique_ptr<recordedDevice> device;
+	double playbackSpeed;
+	asio::io_context ioContext;
+	asio::ip::tcp::acceptor acceptor{ ioContext };
+	std::function<void(const replayResult&)> finishedCallback;
+
+	std::mutex streamMutex;
+	std::vector<std::shared_ptr<asio::ip::tcp::socket>> streamSockets;
+	std::vector<std::thread> streamThreads;
+	std::atomic<bool> stopping = false;
+
+	std::mutex clockMutex;
+	bool started = false;
+	std::chrono::steady_clock::time_point startTime;
+};
+
+#endif// _CAPTURE_H_
@@ -0,0 +1,368 @@
+/*
+Program: ESPFileXfer
+File: csvingest.cpp
+Author: Listerine-debug
+Description: This file contains the implementation of the streaming CSV to columnar
+ingest stage for ESPFileXfer.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+#include "csvingest.h"
+#include "charconv"
+#include "cstring"
+#include "algorithm"
+#include "limits"
+#include "cstdio"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include "emmintrin.h"
+#define CSV_INGEST_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include "intrin.h"
+#endif
+
+static const char columnMagic[8] = { 'E', 'S', 'P', 'C', 'O', 'L', '0', '1' };
+
+static inline unsigned countTrailingZeros(unsigned mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+template <typename T>
+static void writeRaw(std::ostream& out, T value)
+{
+	out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static std::string rawBytes(T value)
+{
+	return std::string(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+csvColumnarWriter::~csvColumnarWriter()
+{
+	abort();
+}
+
+bool csvColumnarWriter::open(const std::string& path)
+{
+	// A transfer that fails halfway must not leave a file without a footer under the real name
+	finalPath = path;
+	partialPath = path + ".part";
+	columnFile.open(partialPath, std::ios::binary | std::ios::trunc);
+	if (!columnFile) return false;
+
+	columnFile.write(columnMagic, sizeof(columnMagic));
+	return true;
+}
+
+void csvColumnarWriter::feed(const char* data, std::size_t len)
+{
+	std::size_t fieldStart = 0;
+
+	// Only commas, newlines and quotes need attention, everything else is skipped in bulk
+	auto handle = [&](std::size_t position)
+		{
+			char c = data[position];
+			if (c == '"')
+			{
+				inQuotes = !inQuotes;
+				return;
+			}
+			if (inQuotes) return;
+
+			endField(data + fieldStart, position - fieldStart);
+			if (c == '\n') endRow();
+			fieldStart = position + 1;
+		};
+
+	std::size_t position = 0;
+#ifdef CSV_INGEST_SSE2
+	const __m128i comma = _mm_set1_epi8(',');
+	const __m128i newline = _mm_set1_epi8('\n');
+	const __m128i quote = _mm_set1_epi8('"');
+	for (; position + 16 <= len; position += 16)
+	{
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position));
+		__m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, comma), _mm_cmpeq_epi8(chunk, newline)),
+			_mm_cmpeq_epi8(chunk, quote));
+		unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+		while (mask)
+		{
+			handle(position + countTrailingZeros(mask));
+			mask &= mask - 1;
+		}
+	}
+#endif
+	for (; position < len; ++position)
+	{
+		char c = data[position];
+		if (c == ',' || c == '\n' || c == '"')
+			handle(position);
+	}
+
+	fieldCarry.append(data + fieldStart, len - fieldStart);
+}
+
+void csvColumnarWriter::endField(const char* data, std::size_t len)
+{
+	std::string joined;
+	if (!fieldCarry.empty())
+	{
+		joined.swap(fieldCarry);
+		joined.append(data, len);
+		data = joined.data();
+		len = joined.size();
+	}
+
+	if (len > 0 && data[len - 1] == '\r') --len;
+
+	std::string unquoted;
+	if (len >= 2 && data[0] == '"' && data[len - 1] == '"')
+	{
+		for (std::size_t i = 1; i + 1 < len; ++i)
+		{
+			unquoted.push_back(data[i]);
+			if (data[i] == '"' && data[i + 1] == '"') ++i;
+		}
+		data = unquoted.data();
+		len = unquoted.size();
+	}
+
+	lastFieldEmpty = (len == 0);
+	if (!headerDone)
+	{
+		columnNames.emplace_back(data, len);
+	}
+	else if (fieldIndex < columns.size())
+	{
+		columnBuffer& column = columns[fieldIndex];
+		column.bytes.append(data, len);
+		column.offsets.push_back(static_cast<uint32_t>(column.bytes.size()));
+	}
+	++fieldIndex;
+}
+
+void csvColumnarWriter::endRow()
+{
+	bool blankLine = (fieldIndex == 1 && lastFieldEmpty);
+	if (!headerDone)
+	{
+		if (blankLine)
+		{
+			columnNames.clear();
+		}
+		else
+		{
+			headerDone = true;
+			columns.resize(columnNames.size());
+		}
+		fieldIndex = 0;
+		return;
+	}
+
+	if (blankLine)
+	{
+		if (!columns.empty()) columns[0].offsets.pop_back();
+		fieldIndex = 0;
+		return;
+	}
+
+	// Short rows are padded with nulls, extra fields were already dropped
+	for (std::size_t i = fieldIndex; i < columns.size(); ++i)
+		columns[i].offsets.push_back(static_cast<uint32_t>(columns[i].bytes.size()));
+	fieldIndex = 0;
+
+	++totalRows;
+	if (++blockRows == BLOCK_ROWS)
+		flushBlock();
+}
+
+csvColumnarWriter::columnStats csvColumnarWriter::writeColumn(const columnBuffer& column)
+{
+	const std::size_t rows = column.size();
+	std::vector<uint8_t> nulls((rows + 7) / 8, 0);
+	bool hasNulls = false;
+	bool allInt = true;
+	bool allFloat = true;
+	std::vector<int64_t> ints(rows, 0);
+	std::vector<double> floats(rows, 0.0);
+
+	for (std::size_t row = 0; row < rows && (allInt || allFloat); ++row)
+	{
+		const char* begin = column.bytes.data() + column.offsets[row];
+		const char* end = column.bytes.data() + column.offsets[row + 1];
+		if (begin == end)
+		{
+			nulls[row / 8] |= static_cast<uint8_t>(1u << (row % 8));
+			hasNulls = true;
+			continue;
+		}
+
+		const char* numberBegin = (*begin == '+') ? begin + 1 : begin;
+		if (allInt)
+		{
+			auto result = std::from_chars(numberBegin, end, ints[row]);
+			allInt = result.ec == std::errc() && result.ptr == end;
+		}
+		if (allFloat)
+		{
+			auto result = std::from_chars(numberBegin, end, floats[row]);
+			allFloat = result.ec == std::errc() && result.ptr == end;
+		}
+	}
+
+	columnStats stats;
+	stats.type = allInt ? columnType::INT64 : (allFloat ? columnType::FLOAT64 : columnType::STRING);
+
+	std::string payload;
+	if (stats.type == columnType::INT64)
+	{
+		int64_t min = INT64_MAX;
+		int64_t max = INT64_MIN;
+		for (std::size_t row = 0; row < rows; ++row)
+		{
+			if (nulls[row / 8] & (1u << (row % 8))) continue;
+			min = std::min(min, ints[row]);
+			max = std::max(max, ints[row]);
+		}
+		payload.assign(reinterpret_cast<const char*>(ints.data()), rows * sizeof(int64_t));
+		stats.min = rawBytes(min);
+		stats.max = rawBytes(max);
+	}
+	else if (stats.type == columnType::FLOAT64)
+	{
+		double min = std::numeric_limits<double>::infinity();
+		double max = -std::numeric_limits<double>::infinity();
+		for (std::size_t row = 0; row < rows; ++row)
+		{
+			if (nulls[row / 8] & (1u << (row % 8))) continue;
+			min = std::min(min, floats[row]);
+			max = std::max(max, floats[row]);
+		}
+		payload.assign(reinterpret_cast<const char*>(floats.data()), rows * sizeof(double));
+		stats.min = rawBytes(min);
+		stats.max = rawBytes(max);
+	}
+	else
+	{
+		// Text columns keep empty strings as values rather than nulls
+		hasNulls = false;
+		bool first = true;
+		for (std::size_t row = 0; row < rows; ++row)
+		{
+			std::string value = column.value(row);
+			if (first || value < stats.min) stats.min = value;
+			if (first || value > stats.max) stats.max = value;
+			first = false;
+		}
+		payload.assign(reinterpret_cast<const char*>(column.offsets.data()), column.offsets.size() * sizeof(uint32_t));
+		payload.append(column.bytes);
+	}
+
+	columnFile.put(static_cast<char>(stats.type));
+	columnFile.put(hasNulls ? 1 : 0);
+	if (hasNulls)
+		columnFile.write(reinterpret_cast<const char*>(nulls.data()), nulls.size());
+	writeRaw<uint32_t>(columnFile, static_cast<uint32_t>(payload.size()));
+	columnFile.write(payload.data(), payload.size());
+	return stats;
+}
+
+void csvColumnarWriter::flushBlock()
+{
+	if (blockRows == 0) return;
+
+	blockIndex block;
+	block.offset = static_cast<uint64_t>(columnFile.tellp());
+	block.rows = blockRows;
+	for (auto& column : columns)
+	{
+		block.columns.push_back(writeColumn(column));
+		column.clear();
+	}
+	blocks.push_back(std::move(block));
+	blockRows = 0;
+}
+
+bool csvColumnarWriter::finish()
+{
+	if (!columnFile.is_open()) return false;
+
+	// Last line without a trailing newline
+	if (!fieldCarry.empty() || fieldIndex > 0)
+	{
+		endField("", 0);
+		endRow();
+	}
+	flushBlock();
+
+	uint64_t footerOffset = static_cast<uint64_t>(columnFile.tellp());
+	writeRaw<uint32_t>(columnFile, static_cast<uint32_t>(columnNames.size()));
+	for (const auto& name : columnNames)
+	{
+		writeRaw<uint16_t>(columnFile, static_cast<uint16_t>(std::min<std::size_t>(name.size(), UINT16_MAX)));
+		columnFile.write(name.data(), std::min<std::size_t>(name.size(), UINT16_MAX));
+	}
+
+	writeRaw<uint32_t>(columnFile, static_cast<uint32_t>(blocks.size()));
+	for (const auto& block : blocks)
+	{
+		writeRaw<uint64_t>(columnFile, block.offset);
+		writeRaw<uint32_t>(columnFile, block.rows);
+		for (const auto& stats : block.columns)
+		{
+			columnFile.put(static_cast<char>(stats.type));
+			if (stats.type == columnType::STRING)
+			{
+				writeRaw<uint32_t>(columnFile, static_cast<uint32_t>(stats.min.size()));
+				columnFile.write(stats.min.data(), stats.min.size());
+				writeRaw<uint32_t>(columnFile, static_cast<uint32_t>(stats.max.size()));
+				columnFile.write(stats.max.data(), stats.max.size());
+			}
+			else
+			{
+				columnFile.write(stats.min.data(), stats.min.size());
+				columnFile.write(stats.max.data(), stats.max.size());
+			}
+		}
+	}
+
+	writeRaw<uint64_t>(columnFile, footerOffset);
+	columnFile.write(columnMagic, sizeof(columnMagic));
+	columnFile.close();
+	if (columnFile.fail())
+	{
+		abort();
+		return false;
+	}
+
+	// rename does not replace an existing file on Windows
+	std::remove(finalPath.c_str());
+	if (std::rename(partialPath.c_str(), finalPath.c_str()) != 0)
+	{
+		abort();
+		return false;
+	}
+	partialPath.clear();
+	return true;
+}
+
+void csvColumnarWriter::abort()
+{
+	if (columnFile.is_open())
+		columnFile.close();
+	if (!partialPath.empty())
+		std::remove(partialPath.c_str());
+	partialPath.clear();
+}
@@ -0,0 +1,102 @@
+/*
+Program: ESPFileXfer
+File: csvingest.h
+Author: Listerine-debug
+Description: This file contains the declarations for the streaming CSV ingest stage,
+which parses extracted sensor CSV as it arrives and writes it out as a typed columnar
+file with a per-block min/max index.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+
+#ifndef _CSVINGEST_H_
+#define _CSVINGEST_H_
+
+#include "string"
+#include "vector"
+#include "fstream"
+#include "cstdint"
+
+// Columnar file layout (little endian):
+//   "ESPCOL01"
+//   blocks  : per column: uint8 type, uint8 hasNulls, [null bitmap], uint32 payload length, payload
+//             INT64/FLOAT64 payload = rows x 8 bytes, STRING payload = uint32 offsets[rows + 1] + bytes
+//   footer  : uint32 column count, names, uint32 block count,
+//             per block: uint64 offset, uint32 rows, per column: uint8 type, min, max
+//   trailer : uint64 footer offset, "ESPCOL01"
+// Types are inferred per block, so a column that turns from integers to text later in
+// the file does not invalidate blocks that were already written.
+enum class columnType : uint8_t
+{
+	INT64 = 0x01,
+	FLOAT64 = 0x02,
+	STRING = 0x03
+};
+
+class csvColumnarWriter
+{
+public:
+	~csvColumnarWriter();
+
+	// Writes to path + ".part", only finish() puts a complete file at path
+	bool open(const std::string& path);
+
+	// Accepts arbitrary chunks straight off the socket, rows may span calls
+	void feed(const char* data, std::size_t len);
+
+	// Flushes the last row and block, writes the footer and renames the file into place
+	bool finish();
+
+	// Closes and deletes the partial file, also done on destruction without finish()
+	void abort();
+
+	uint64_t rowCount() const { return totalRows; }
+
+	static const uint32_t BLOCK_ROWS = 65536;
+
+private:
+	struct columnBuffer
+	{
+		std::string bytes;
+		std::vector<uint32_t> offsets{ 0 };
+		std::size_t size() const { return offsets.size() - 1; }
+		std::string value(std::size_t row) const { return bytes.substr(offsets[row], offsets[row + 1] - offsets[row]); }
+		void clear() { bytes.clear(); offsets.assign(1, 0); }
+	};
+
+	struct columnStats
+	{
+		columnType type;
+		std::string min;	// raw 8 bytes for numeric columns
+		std::string max;
+	};
+
+	struct blockIndex
+	{
+		uint64_t offset;
+		uint32_t rows;
+		std::vector<columnStats> columns;
+	};
+
+	void endField(const char* data, std::size_t len);
+	void endRow();
+	void flushBlock();
+	columnStats writeColumn(const columnBuffer& column);
+
+	std::ofstream columnFile;
+	std::string finalPath;
+	std::string partialPath;
+	std::vector<std::string> columnNames;
+	std::vector<columnBuffer> columns;
+	std::vector<blockIndex> blocks;
+	bool headerDone = false;
+	bool inQuotes = false;
+	bool lastFieldEmpty = false;
+	std::size_t fieldIndex = 0;
+	std::string fieldCarry;
+	uint32_t blockRows = 0;
+	uint64_t totalRows = 0;
+};
+
+#endif// _CSVINGEST_H_
@@ -0,0 +1,178 @@
+/*
+Program: ESPFileXfer
+File: devicelink.cpp
+Author: Listerine-debug
+Description: This file contains the implementation of the blocking, timeout aware
+connection to the ESPFileXfer firmware.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+#include "devicelink.h"
+#include "capture.h"
+#include "stdexcept"
+#include "vector"
+
+using asio::ip::tcp;
+
+deviceLink::deviceLink(const std::string& ipAddress, const std::string& port)
+	: serverIp(ipAddress), serverPort(port)
+{
+}
+
+void deviceLink::connect(std::chrono::milliseconds timeout)
+{
+	timedConnect(ioContext, socket, serverIp, serverPort, timeout);
+	if (recorder) stream = recorder->newStream();
+
+	// Any failure past this point leaves a connected socket behind, close it so the
+	// next connect() starts from scratch instead of failing with "already connected"
+	try
+	{
+		char handshakeCmd = static_cast<char>(HANDSHAKE);
+		send(&handshakeCmd, 1);
+
+		char response = 0;
+		readExact(&response, 1);
+		if (response != static_cast<char>(HANDSHAKE))
+			throw std::runtime_error("Handshake failed");
+	}
+	catch (...)
+	{
+		close();
+		throw;
+	}
+}
+
+void deviceLink::close()
+{
+	asio::error_code ignored;
+	socket.shutdown(tcp::socket::shutdown_both, ignored);
+	socket.close(ignored);
+}
+
+void deviceLink::readExact(char* data, std::size_t len)
+{
+	timedRead(ioContext, socket, data, len, readTimeout);
+	if (recorder) recorder->record(captureDirection::READ, data, len, stream);
+}
+
+void deviceLink::send(const char* data, std::size_t len)
+{
+	asio::write(socket, asio::buffer(data, len));
+	if (recorder) recorder->record(captureDirection::WRITE, data, len, stream);
+}
+
+void deviceLink::writeCommand(uint8_t command, const std::string& path, const char* args, std::size_t argsLen)
+{
+	if (path.size() > UINT16_MAX)
+		throw std::runtime_error("Remote path too long");
+
+	std::vector<char> request(1 + 2 + path.size() + argsLen);
+	request[0] = static_cast<char>(command);
+	putLittleEndian(&request[1], path.size(), 2);
+	std::copy(path.begin(), path.end(), request.begin() + 3);
+	std::copy(args, args + argsLen, request.begin() + 3 + path.size());
+
+	send(request.data(), request.size());
+}
+
+void deviceLink::readStatus(const char* what)
+{
+	char status = 0;
+	readExact(&status, 1);
+	if (status != static_cast<char>(SUCCESS))
+		throw std::runtime_error(std::string(what) + " rejected by device");
+}
+
+uint64_t deviceLink::fileSize(const std::string& path)
+{
+	writeCommand(FILE_SIZE, path, nullptr, 0);
+	readStatus("Size request");
+
+	char size[4];
+	readExact(size, sizeof(size));
+	return getLittleEndian(size, 4);
+}
+
+void deviceLink::requestRange(const std::string& path, uint64_t offset, uint32_t length)
+{
+	if (offset > UINT32_MAX)
+		throw std::runtime_error("Range offset beyond device limit");
+
+	char args[8];
+	putLittleEndian(args, offset, 4);
+	putLittleEndian(args + 4, length, 4);
+	writeCommand(FILE_RANGE, path, args, sizeof(args));
+	readStatus("Range request");
+}
+
+std::vector<remoteEntry> deviceLink::listDirectory(const std::string& path, uint32_t start, uint16_t count)
+{
+	if (count == 0) return {};
+
+	char args[6];
+	putLittleEndian(args, start, 4);
+	putLittleEndian(args + 4, count, 2);
+	writeCommand(LIST_DIRECTORY, path, args, sizeof(args));
+	readStatus("Directory listing");
+
+	std::vector<remoteEntry> entries;
+	for (;;)
+	{
+		char kind = 0;
+		readExact(&kind, 1);
+		if (static_cast<uint8_t>(kind) == END_OF_LIST) break;
+
+		char header[10];
+		readExact(header, sizeof(header));
+
+		remoteEntry entry;
+		entry.isDirectory = kind != 0;
+		entry.size = getLittleEndian(header, 4);
+		entry.modified = getLittleEndian(header + 4, 4);
+		entry.name.resize(getLittleEndian(header + 8, 2));
+		if (!entry.name.empty())
+			readExact(&entry.name[0], entry.name.size());
+		entries.push_back(std::move(entry));
+	}
+	return entries;
+}
+
+std::vector<uint32_t> deviceLink::pageChecksums(const std::string& path, uint8_t pageSize, uint32_t& total)
+{
+	char args[1] = { static_cast<char>(pageSize) };
+	writeCommand(PAGE_CHECKSUMS, path, args, sizeof(args));
+	readStatus("Directory checksums");
+
+	std::vector<uint32_t> checksums;
+	total = 0;
+	for (;;)
+	{
+		char entries = 0;
+		readExact(&entries, 1);
+		if (entries == 0) break;
+
+		char checksum[4];
+		readExact(checksum, sizeof(checksum));
+		checksums.push_back(getLittleEndian(checksum, 4));
+		total += static_cast<uint8_t>(entries);
+	}
+	return checksums;
+}
+
+uint8_t deviceLink::capabilities()
+{
+	char command = static_cast<char>(CAPABILITIES);
+	send(&command, 1);
+
+	// Firmware from before the query answers unknown commands with FAILURE
+	char status = 0;
+	readExact(&status, 1);
+	if (status != static_cast<char>(SUCCESS))
+		return 0;
+
+	char flags = 0;
+	readExact(&flags, 1);
+	return static_cast<uint8_t>(flags);
+}
@@ -0,0 +1,71 @@
+/*
+Program: ESPFileXfer
+File: devicelink.h
+Author: Listerine-debug
+Description: This file contains the declarations for a blocking, timeout aware connection
+to the ESPFileXfer firmware, used by features that open their own TCP connections
+next to the interactive wifiSerialFrame socket.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+
+#ifndef _DEVICELINK_H_
+#define _DEVICELINK_H_
+
+#include "deviceprotocol.h"
+#include "string"
+#include "vector"
+#include "chrono"
+#include "cstdint"
+
+struct remoteEntry
+{
+	std::string name;
+	bool isDirectory = false;
+	uint32_t size = 0;
+	uint32_t modified = 0;	// seconds since epoch, as reported by the device
+};
+
+// The request and reply layouts are described in deviceprotocol.h
+class deviceLink : public deviceProtocol
+{
+public:
+	deviceLink(const std::string& ipAddress, const std::string& port);
+
+	// Connects and performs the handshake, throws on failure
+	void connect(std::chrono::milliseconds timeout = std::chrono::milliseconds(3000));
+	void close();
+
+	uint64_t fileSize(const std::string& path);
+	void requestRange(const std::string& path, uint64_t offset, uint32_t length);
+	std::vector<remoteEntry> listDirectory(const std::string& path, uint32_t start, uint16_t count);
+	std::vector<uint32_t> pageChecksums(const std::string& path, uint8_t pageSize, uint32_t& total);
+	uint8_t capabilities();
+	void readExact(char* data, std::size_t len);
+
+	// Traffic of every later connect() goes to recorder as a stream of its own, nullptr stops it
+	void setRecorder(sessionRecorder* sessionRecorder) { recorder = sessionRecorder; }
+
+	std::chrono::milliseconds readTimeout = std::chrono::milliseconds(5000);
+
+	// Client slots the sample firmware serves (MAX_CLIENTS in the sketch). The WiFi window,
+	// the SD browser and the RPC console each hold one, the rest are for download streams.
+	static constexpr unsigned DEVICE_CLIENT_SLOTS = 8;
+	static constexpr unsigned RESERVED_CLIENT_SLOTS = 3;
+	static constexpr unsigned MAX_CONNECTIONS = DEVICE_CLIENT_SLOTS - RESERVED_CLIENT_SLOTS;
+
+private:
+	void writeCommand(uint8_t command, const std::string& path, const char* args, std::size_t argsLen);
+	void readStatus(const char* what);
+	void send(const char* data, std::size_t len);
+
+	std::string serverIp;
+	std::string serverPort;
+	asio::io_context ioContext;
+	asio::ip::tcp::socket socket{ ioContext };
+	sessionRecorder* recorder = nullptr;
+	uint32_t stream = 0;
+};
+
+#endif// _DEVICELINK_H_
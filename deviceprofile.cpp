@@ -0,0 +1,131 @@
+/*
+Program: ESPFileXfer
+File: deviceprofile.cpp
+Author: Listerine-debug
+Description: This file contains the implementation of per-device link profile tuning
+for ESPFileXfer.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+#include "deviceprofile.h"
+#include "devicelink.h"
+#include "algorithm"
+#include "iterator"
+
+transferSettings deviceProfile::candidate() const
+{
+	transferSettings settings = tuned();
+	if (probeAxis == 0)
+	{
+		uint32_t size = probeDirection > 0 ? chunkSize * 2 : chunkSize / 2;
+		settings.chunkSize = std::min(std::max(size, MIN_CHUNK_SIZE), MAX_CHUNK_SIZE);
+	}
+	else
+	{
+		unsigned count = probeDirection > 0 ? connections + 1 : connections - 1;
+		settings.connections = std::min(std::max(count, 1u), deviceLink::MAX_CONNECTIONS);
+	}
+	return settings;
+}
+
+transferSettings deviceProfile::nextTransfer() const
+{
+	// The first transfer after a (re-)probe starts measures the tuned settings as a baseline
+	if (!probing || typicalThroughput <= 0)
+		return tuned();
+	return candidate();
+}
+
+void deviceProfile::advanceProbe()
+{
+	// Cycles chunk up, chunk down, connections up, connections down, skipping moves that hit a limit
+	do
+	{
+		probeDirection = -probeDirection;
+		if (probeDirection > 0)
+			probeAxis ^= 1;
+		if (++probeMisses >= 4)
+		{
+			probing = false;
+			return;
+		}
+	} while (candidate() == tuned());
+}
+
+bool deviceProfile::recordTransfer(const transferSettings& used, uint64_t bytes, double bytesPerSecond)
+{
+	if (bytes < MIN_TUNING_BYTES || bytesPerSecond <= 0)
+		return false;
+	throughput = bytesPerSecond;
+
+	if (!probing)
+	{
+		if (!(used == tuned()))
+			return false;
+
+		if (typicalThroughput > 0 && bytesPerSecond < typicalThroughput * REPROBE_FRACTION)
+		{
+			// The link or the device changed, look for better settings starting from this measurement
+			probing = true;
+			probeAxis = 0;
+			probeDirection = 1;
+			probeMisses = 0;
+			typicalThroughput = bytesPerSecond;
+			if (candidate() == tuned())
+				advanceProbe();
+			return true;
+		}
+
+		// Follows slow drift in either direction, one lucky or unlucky transfer only moves it a quarter of the way
+		typicalThroughput = typicalThroughput > 0 ? 0.75 * typicalThroughput + 0.25 * bytesPerSecond : bytesPerSecond;
+		return false;
+	}
+
+	if (used == tuned())
+	{
+		typicalThroughput = bytesPerSecond;
+		if (candidate() == tuned())
+			advanceProbe();
+		return false;
+	}
+	if (!(used == candidate()))
+		return false;
+
+	if (bytesPerSecond > typicalThroughput * PROBE_GAIN)
+	{
+		// Keep going the same way from the new settings
+		chunkSize = used.chunkSize;
+		connections = used.connections;
+		typicalThroughput = bytesPerSecond;
+		probeMisses = 0;
+		if (candidate() == tuned())
+			advanceProbe();
+	}
+	else
+	{
+		advanceProbe();
+	}
+	return false;
+}
+
+unsigned deviceProfile::nextBaudRate(unsigned baudRate)
+{
+	const unsigned* rate = std::find(std::begin(BAUD_RATES), std::end(BAUD_RATES), baudRate);
+	if (rate == std::end(BAUD_RATES) || ++rate == std::end(BAUD_RATES))
+		return BAUD_RATES[0];
+	return *rate;
+}
+
+std::size_t deviceProfile::textByteCount(const char* data, std::size_t len)
+{
+	// A wrong baud rate turns text into mostly control and high bytes
+	std::size_t count = 0;
+	for (std::size_t i = 0; i < len; ++i)
+	{
+		unsigned char c = static_cast<unsigned char>(data[i]);
+		if ((c >= 0x20 && c < 0x7F) || c == '\r' || c == '\n' || c == '\t')
+			++count;
+	}
+	return count;
+}
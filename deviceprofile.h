@@ -0,0 +1,81 @@
+/*
+Program: ESPFileXfer
+File: deviceprofile.h
+Author: Listerine-debug
+Description: This file contains the declarations for per-device link profiles, which
+remember a device's address, serial baud rate, transfer settings and capabilities so
+new sessions start from tuned values instead of defaults.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+
+#ifndef _DEVICEPROFILE_H_
+#define _DEVICEPROFILE_H_
+
+#include "string"
+#include "cstddef"
+#include "cstdint"
+
+struct transferSettings
+{
+	uint32_t chunkSize;
+	unsigned connections;
+
+	bool operator==(const transferSettings& other) const { return chunkSize == other.chunkSize && connections == other.connections; }
+};
+
+// Transfer settings are tuned by hill climbing across real transfers. While probing,
+// each transfer tries one neighbour of the tuned settings (chunk size doubled or halved,
+// one connection more or fewer) and keeps it if it was clearly faster. Probing stops
+// once every neighbour has been tried without a gain, and starts again when a transfer
+// with the tuned settings falls well below the throughput the device usually reaches.
+struct deviceProfile
+{
+	std::string name;
+	std::string lastIp;
+	std::string lastPort;
+	unsigned baudRate = DEFAULT_BAUD_RATE;
+	bool baudRateSaved = false;		// confirmed by readable text or chosen by the user
+	uint32_t chunkSize = DEFAULT_CHUNK_SIZE;
+	unsigned connections = DEFAULT_CONNECTIONS;
+	unsigned rpcWindow = DEFAULT_RPC_WINDOW;
+	bool capabilitiesKnown = false;
+	bool supportsCompression = false;
+	double throughput = 0;			// bytes per second of the last transfer
+	double typicalThroughput = 0;	// what the tuned settings usually reach
+
+	bool probing = true;
+	int probeAxis = 0;				// 0 = chunk size, 1 = connections
+	int probeDirection = 1;
+	int probeMisses = 0;
+
+	// Settings for the next transfer, a probe candidate while probing
+	transferSettings nextTransfer() const;
+
+	// Folds a finished transfer in. Returns true when it started a re-probe.
+	bool recordTransfer(const transferSettings& used, uint64_t bytes, double bytesPerSecond);
+
+	transferSettings tuned() const { return { chunkSize, connections }; }
+	transferSettings candidate() const;
+
+	// Next rate to try when serial data arrives garbled
+	static unsigned nextBaudRate(unsigned baudRate);
+	static std::size_t textByteCount(const char* data, std::size_t len);
+
+	static constexpr unsigned DEFAULT_BAUD_RATE = 115200;
+	static constexpr uint32_t DEFAULT_CHUNK_SIZE = 32 * 1024;
+	static constexpr uint32_t MIN_CHUNK_SIZE = 4 * 1024;
+	static constexpr uint32_t MAX_CHUNK_SIZE = 256 * 1024;
+	static constexpr unsigned DEFAULT_CONNECTIONS = 4;
+	static constexpr unsigned DEFAULT_RPC_WINDOW = 16;
+	static constexpr uint64_t MIN_TUNING_BYTES = 256 * 1024;	// smaller transfers are dominated by setup time
+	static constexpr double PROBE_GAIN = 1.05;
+	static constexpr double REPROBE_FRACTION = 0.5;
+	static constexpr unsigned BAUD_RATES[] = { 115200, 921600, 460800, 230400, 74880, 57600, 38400, 19200, 9600 };
+
+private:
+	void advanceProbe();
+};
+
+#endif// _DEVICEPROFILE_H_
@@ -0,0 +1,115 @@
+/*
+Program: ESPFileXfer
+File: deviceprotocol.cpp
+Author: Listerine-debug
+Description: This file contains the implementation of the helpers shared by every TCP
+connection to the ESPFileXfer firmware.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+#include "deviceprotocol.h"
+#include "capture.h"
+#include "algorithm"
+#include "stdexcept"
+
+using asio::ip::tcp;
+
+void deviceProtocol::putLittleEndian(char* out, uint64_t value, int bytes)
+{
+	for (int i = 0; i < bytes; ++i)
+		out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+uint32_t deviceProtocol::getLittleEndian(const char* in, int bytes)
+{
+	uint32_t value = 0;
+	for (int i = 0; i < bytes; ++i)
+		value |= static_cast<uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+	return value;
+}
+
+void deviceProtocol::timedConnect(asio::io_context& ioContext, tcp::socket& socket,
+	const std::string& ipAddress, const std::string& port, std::chrono::milliseconds timeout)
+{
+	tcp::endpoint endpoint(asio::ip::make_address(ipAddress), std::stoi(port));
+
+	asio::error_code result = asio::error::would_block;
+	socket.async_connect(endpoint, [&](const asio::error_code& error) { result = error; });
+	ioContext.restart();
+	ioContext.run_for(timeout);
+
+	asio::error_code ignored;
+	if (!ioContext.stopped())
+	{
+		socket.close(ignored);
+		ioContext.run();
+		throw std::runtime_error("Connection to " + ipAddress + ":" + port + " timed out");
+	}
+	if (result)
+	{
+		socket.close(ignored);
+		throw asio::system_error(result);
+	}
+
+	// Requests are a few bytes each, do not let Nagle hold them back
+	socket.set_option(tcp::no_delay(true), result);
+	if (result)
+	{
+		socket.close(ignored);
+		throw asio::system_error(result);
+	}
+}
+
+void deviceProtocol::timedRead(asio::io_context& ioContext, tcp::socket& socket,
+	char* data, std::size_t len, std::chrono::milliseconds timeout)
+{
+	asio::error_code result = asio::error::would_block;
+	asio::async_read(socket, asio::buffer(data, len),
+		[&](const asio::error_code& error, std::size_t) { result = error; });
+
+	ioContext.restart();
+	ioContext.run_for(timeout);
+	if (!ioContext.stopped())
+	{
+		// Stalled stream, abort the read and let the caller decide what to do
+		asio::error_code ignored;
+		socket.close(ignored);
+		ioContext.run();
+		throw std::runtime_error("Read timed out");
+	}
+	if (result)
+		throw asio::system_error(result);
+}
+
+uint64_t deviceProtocol::extractFile(tcp::socket& socket, sessionRecorder& recorder,
+	const std::function<void(const char* data, std::size_t len)>& onData)
+{
+	char handshakeCmd = static_cast<char>(HANDSHAKE);
+	asio::write(socket, asio::buffer(&handshakeCmd, 1));
+	recorder.record(captureDirection::WRITE, &handshakeCmd, 1);
+
+	char response = 0;
+	asio::read(socket, asio::buffer(&response, 1));
+	recorder.record(captureDirection::READ, &response, 1);
+	if (response != static_cast<char>(HANDSHAKE))
+		throw std::runtime_error("Handshake failed. Extraction aborted.");
+
+	char extractCmd = static_cast<char>(EXTRACT);
+	asio::write(socket, asio::buffer(&extractCmd, 1));
+	recorder.record(captureDirection::WRITE, &extractCmd, 1);
+
+	// The file ends at the first SUCCESS byte, the firmware does not frame it otherwise
+	char buffer[128];
+	uint64_t totalRead = 0;
+	while (true)
+	{
+		std::size_t len = socket.read_some(asio::buffer(buffer, sizeof(buffer)));
+		recorder.record(captureDirection::READ, buffer, len);
+		totalRead += len;
+
+		const char* success = std::find(buffer, buffer + len, static_cast<char>(SUCCESS));
+		if (success > buffer) onData(buffer, success - buffer);
+		if (success != buffer + len) return totalRead;
+	}
+}
@@ -0,0 +1,69 @@
+/*
+Program: ESPFileXfer
+File: deviceprotocol.h
+Author: Listerine-debug
+Description: This file contains the command bytes, little endian helpers and timed socket
+operations shared by every TCP connection to the ESPFileXfer firmware.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+
+#ifndef _DEVICEPROTOCOL_H_
+#define _DEVICEPROTOCOL_H_
+
+#include "asio.hpp"
+#include "string"
+#include "chrono"
+#include "functional"
+#include "cstdint"
+
+class sessionRecorder;
+
+// Requests are a command byte followed by little endian arguments. Paths are
+// sent as uint16 length + bytes. Replies start with SUCCESS or FAILURE.
+//   HANDSHAKE  : (no arguments)               -> HANDSHAKE
+//   EXTRACT    : (no arguments)               -> file bytes, SUCCESS
+//   FILE_SIZE  : path                         -> SUCCESS, uint32 size
+//   FILE_RANGE : path, uint32 offset, uint32 length -> SUCCESS, length bytes
+//   LIST_DIRECTORY : path, uint32 start, uint16 count -> SUCCESS, entries, 0xFF
+//     entry : uint8 isDirectory, uint32 size, uint32 modified, uint16 name length, name
+//   RPC        : see rpcchannel.h
+//   CAPABILITIES : (no arguments)             -> SUCCESS, uint8 CAP_* flags
+//   PAGE_CHECKSUMS : path, uint8 page size     -> SUCCESS, per page: uint8 entries, uint32 checksum, then 0
+//     checksum : FNV-1a over each entry's name, uint8 isDirectory, uint32 size, uint32 modified
+struct deviceProtocol
+{
+	static constexpr uint8_t EXTRACT = 0x00;
+	static constexpr uint8_t HANDSHAKE = 0x01;
+	static constexpr uint8_t FAILURE = 0x02;
+	static constexpr uint8_t SUCCESS = 0x03;
+	static constexpr uint8_t FILE_SIZE = 0x04;
+	static constexpr uint8_t FILE_RANGE = 0x05;
+	static constexpr uint8_t LIST_DIRECTORY = 0x06;
+	static constexpr uint8_t RPC = 0x07;
+	static constexpr uint8_t CAPABILITIES = 0x08;
+	static constexpr uint8_t PAGE_CHECKSUMS = 0x09;
+	static constexpr uint8_t END_OF_LIST = 0xFF;
+
+	static constexpr uint8_t CAP_COMPRESSION = 0x01;
+
+	static void putLittleEndian(char* out, uint64_t value, int bytes);
+	static uint32_t getLittleEndian(const char* in, int bytes);
+
+	// Both run ioContext on the calling thread and throw on failure. timedConnect closes the
+	// socket on any failure and timedRead on a timeout, so the next attempt starts from scratch.
+	static void timedConnect(asio::io_context& ioContext, asio::ip::tcp::socket& socket,
+		const std::string& ipAddress, const std::string& port, std::chrono::milliseconds timeout);
+	static void timedRead(asio::io_context& ioContext, asio::ip::tcp::socket& socket,
+		char* data, std::size_t len, std::chrono::milliseconds timeout);
+
+	// Runs HANDSHAKE then EXTRACT on a connected socket and hands the file bytes to onData until
+	// SUCCESS. All traffic goes to recorder while it is open. Returns how many bytes were read
+	// after EXTRACT, counting SUCCESS and anything that arrived in the same read. Blocks without
+	// a timeout and throws when the handshake is refused or the socket fails.
+	static uint64_t extractFile(asio::ip::tcp::socket& socket, sessionRecorder& recorder,
+		const std::function<void(const char* data, std::size_t len)>& onData);
+};
+
+#endif// _DEVICEPROTOCOL_H_
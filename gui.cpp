@@ -10,6 +10,96 @@ Date of Last Implementation: 2025-04-21 , YYYY-MM-DD
 
 #include "gui.h"
 
+// Profiles live under /Devices/<name> in the application config. WiFi devices default to
+// <ip>_<port>, which also picks up Connections values saved before profiles existed.
+static std::string profileKey(const std::string& name)
+{
+	std::string key = name;
+	std::replace(key.begin(), key.end(), '/', '_');
+	std::replace(key.begin(), key.end(), '\\', '_');
+	return key;
+}
+
+static deviceProfile loadProfile(const std::string& name)
+{
+	deviceProfile profile;
+	profile.name = profileKey(name);
+	if (profile.name.empty())
+		return profile;
+
+	wxConfigBase* config = wxConfigBase::Get();
+	wxString path = "/Devices/" + wxString::FromUTF8(profile.name);
+	long value = 0;
+
+	profile.lastIp = config->Read(path + "/LastIp", "").ToStdString();
+	profile.lastPort = config->Read(path + "/LastPort", "").ToStdString();
+	profile.baudRate = static_cast<unsigned>(config->ReadLong(path + "/BaudRate", deviceProfile::DEFAULT_BAUD_RATE));
+	profile.baudRateSaved = config->ReadBool(path + "/BaudRateSaved", false);
+
+	value = config->ReadLong(path + "/ChunkSize", deviceProfile::DEFAULT_CHUNK_SIZE);
+	profile.chunkSize = static_cast<uint32_t>(std::min<long>(std::max<long>(value, deviceProfile::MIN_CHUNK_SIZE), deviceProfile::MAX_CHUNK_SIZE));
+	value = config->ReadLong(path + "/Connections", deviceProfile::DEFAULT_CONNECTIONS);
+	profile.connections = static_cast<unsigned>(std::min<long>(std::max<long>(value, 1), deviceLink::MAX_CONNECTIONS));
+	value = config->ReadLong(path + "/RpcWindow", deviceProfile::DEFAULT_RPC_WINDOW);
+	profile.rpcWindow = static_cast<unsigned>(std::min<long>(std::max<long>(value, 1), rpcChannel::MAX_WINDOW));
+
+	profile.capabilitiesKnown = config->ReadBool(path + "/CapabilitiesKnown", false);
+	profile.supportsCompression = config->ReadBool(path + "/Compression", false);
+	config->Read(path + "/Throughput", &profile.throughput, 0.0);
+	config->Read(path + "/TypicalThroughput", &profile.typicalThroughput, 0.0);
+	profile.probing = config->ReadBool(path + "/Probing", true);
+	profile.probeAxis = static_cast<int>(config->ReadLong(path + "/ProbeAxis", 0)) & 1;
+	profile.probeDirection = config->ReadLong(path + "/ProbeDirection", 1) < 0 ? -1 : 1;
+	profile.probeMisses = static_cast<int>(config->ReadLong(path + "/ProbeMisses", 0));
+	return profile;
+}
+
+// Sessions without a name, such as replays, are never persisted
+static void saveProfile(const deviceProfile& profile)
+{
+	if (profile.name.empty())
+		return;
+
+	wxConfigBase* config = wxConfigBase::Get();
+	wxString path = "/Devices/" + wxString::FromUTF8(profile.name);
+
+	config->Write(path + "/LastIp", wxString(profile.lastIp));
+	config->Write(path + "/LastPort", wxString(profile.lastPort));
+	config->Write(path + "/BaudRate", static_cast<long>(profile.baudRate));
+	config->Write(path + "/BaudRateSaved", profile.baudRateSaved);
+	config->Write(path + "/ChunkSize", static_cast<long>(profile.chunkSize));
+	config->Write(path + "/Connections", static_cast<long>(profile.connections));
+	config->Write(path + "/RpcWindow", static_cast<long>(profile.rpcWindow));
+	config->Write(path + "/CapabilitiesKnown", profile.capabilitiesKnown);
+	config->Write(path + "/Compression", profile.supportsCompression);
+	config->Write(path + "/Throughput", profile.throughput);
+	config->Write(path + "/TypicalThroughput", profile.typicalThroughput);
+	config->Write(path + "/Probing", profile.probing);
+	config->Write(path + "/ProbeAxis", static_cast<long>(profile.probeAxis));
+	config->Write(path + "/ProbeDirection", static_cast<long>(profile.probeDirection));
+	config->Write(path + "/ProbeMisses", static_cast<long>(profile.probeMisses));
+	config->Flush();
+}
+
+static std::vector<deviceProfile> loadProfiles()
+{
+	wxConfigBase* config = wxConfigBase::Get();
+	wxString previousPath = config->GetPath();
+	std::vector<std::string> names;
+
+	config->SetPath("/Devices");
+	wxString group;
+	long cookie = 0;
+	for (bool more = config->GetFirstGroup(group, cookie); more; more = config->GetNextGroup(group, cookie))
+		names.push_back(std::string(group.ToUTF8()));
+	config->SetPath(previousPath);
+
+	std::vector<deviceProfile> profiles;
+	for (const auto& name : names)
+		profiles.push_back(loadProfile(name));
+	return profiles;
+}
+
 
 mainFrame::mainFrame(const wxString& title)
 	: wxFrame(NULL, wxID_ANY, title, wxDefaultPosition, wxSize(400, 800), wxDEFAULT_FRAME_STYLE & ~wxMAXIMIZE_BOX)
@@ -25,6 +115,8 @@ mainFrame::mainFrame(const wxString& title)
 	toolMenu->Append(ID_DEVICE_DETAILS, "&Device Details\tCtrl-D", "Show selected device details");
 	toolMenu->Append(ID_DEVICE_CONNECT, "&Connect via Serial\tCtrl-C", "Connect to a microcontrollers COM port");
 	toolMenu->Append(ID_DEVICE_WIFI, "&Connect via WiFi\tCtrl-W", "Connect to a microcontrollers network");
+	toolMenu->Append(ID_REPLAY, "&Replay Capture\tCtrl-R", "Replay a recorded session capture");
+	toolMenu->Append(ID_REPLAY_TEST, "Replay &Test\tCtrl-T", "Run a session capture against the transfer code and check the result");
 
 	wxMenuBar* menuBar = new wxMenuBar;
 	menuBar->Append(fileMenu, "&App");
@@ -43,6 +135,8 @@ mainFrame::mainFrame(const wxString& title)
 	Bind(wxEVT_MENU, &mainFrame::OnConnect, this, ID_DEVICE_CONNECT);
 	Bind(wxEVT_MENU, &mainFrame::OnConnectWiFi, this, ID_DEVICE_WIFI);
 	Bind(wxEVT_MENU, &mainFrame::OnCode, this, ID_CODE);
+	Bind(wxEVT_MENU, &mainFrame::OnReplay, this, ID_REPLAY);
+	Bind(wxEVT_MENU, &mainFrame::OnReplayTest, this, ID_REPLAY_TEST);
 
 	CreateStatusBar();
 	SetStatusText("Welcome to ESPFileXfer!");
@@ -100,11 +194,22 @@ arduinoCode::arduinoCode(const wxString& title)
 		"const char* ssid = \"ESP32_AP\";\n"
 		"const char* password = \"12345678\";\n\n"
 		"WiFiServer server(8080);\n"
-		"WiFiClient client;\n\n"
+		"// Must match deviceLink::DEVICE_CLIENT_SLOTS on the PC, which keeps room for the\n"
+		"// WiFi window, SD browser and RPC console next to the Parallel Extract streams\n"
+		"const int MAX_CLIENTS = 8;\n"
+		"WiFiClient clients[MAX_CLIENTS];\n\n"
 		"const uint8_t CMD_HANDSHAKE = 0x01;\n"
 		"const uint8_t CMD_EXTRACT   = 0x00;\n"
 		"const uint8_t CMD_FAIL      = 0x02;\n"
-		"const uint8_t CMD_SUCCESS   = 0x03;\n\n"
+		"const uint8_t CMD_SUCCESS   = 0x03;\n"
+		"const uint8_t CMD_SIZE      = 0x04;\n"
+		"const uint8_t CMD_RANGE     = 0x05;\n"
+		"const uint8_t CMD_LIST      = 0x06;\n"
+		"const uint8_t CMD_RPC       = 0x07;\n"
+		"const uint8_t CMD_CAPS      = 0x08;\n"
+		"const uint8_t CMD_PAGES     = 0x09;\n"
+		"const uint8_t CAP_COMPRESSION = 0x01;\n"
+		"const uint8_t END_OF_LIST   = 0xFF;\n\n"
 		"const char* filePath = \"/data.txt\";\n\n"
 		"void setup() {\n"
 		"  Serial.begin(115200);\n"
@@ -113,31 +218,73 @@ arduinoCode::arduinoCode(const wxString& title)
 		"  server.begin();\n"
 		"}\n\n"
 		"void loop() {\n"
-		"  if (!client || !client.connected()) {\n"
-		"    client = server.available();\n"
-		"    return;\n"
+		"  WiFiClient incoming = server.available();\n"
+		"  if (incoming) {\n"
+		"    bool placed = false;\n"
+		"    for (int i = 0; i < MAX_CLIENTS && !placed; i++) {\n"
+		"      if (!clients[i] || !clients[i].connected()) {\n"
+		"        incoming.setNoDelay(true);\n"
+		"        clients[i] = incoming;\n"
+		"        placed = true;\n"
+		"      }\n"
+		"    }\n"
+		"    // Refuse rather than leave the PC waiting for a handshake that never comes\n"
+		"    if (!placed) incoming.stop();\n"
 		"  }\n\n"
-		"  if (client.available()) {\n"
-		"    uint8_t cmd = client.read();\n\n"
+		"  for (int i = 0; i < MAX_CLIENTS; i++) {\n"
+		"    WiFiClient& client = clients[i];\n"
+		"    if (!client || !client.connected() || !client.available()) continue;\n\n"
+		"    uint8_t cmd = client.read();\n"
 		"    if (cmd == CMD_HANDSHAKE) {\n"
-		"      client.write(CMD_HANDSHAKE);\n\n"
-		"      if (waitForCommand(CMD_EXTRACT)) {\n"
-		"        sendFile();\n"
-		"      } else {\n"
-		"        client.write(CMD_FAIL);\n"
-		"      }\n"
+		"      client.write(CMD_HANDSHAKE);\n"
+		"    } else if (cmd == CMD_EXTRACT) {\n"
+		"      sendFile(client);\n"
+		"    } else if (cmd == CMD_SIZE) {\n"
+		"      sendSize(client);\n"
+		"    } else if (cmd == CMD_RANGE) {\n"
+		"      sendRange(client);\n"
+		"    } else if (cmd == CMD_LIST) {\n"
+		"      sendListing(client);\n"
+		"    } else if (cmd == CMD_RPC) {\n"
+		"      handleRpc(client);\n"
+		"    } else if (cmd == CMD_PAGES) {\n"
+		"      sendPageChecksums(client);\n"
+		"    } else if (cmd == CMD_CAPS) {\n"
+		"      // This sketch sends files uncompressed, set CAP_COMPRESSION once it does not\n"
+		"      uint8_t reply[2] = { CMD_SUCCESS, 0 };\n"
+		"      client.write(reply, sizeof(reply));\n"
+		"    } else {\n"
+		"      client.write(CMD_FAIL);\n"
 		"    }\n"
 		"  }\n"
 		"}\n\n"
-		"bool waitForCommand(uint8_t expected) {\n"
+		"bool readExact(WiFiClient& client, uint8_t* buffer, size_t len) {\n"
 		"  unsigned long start = millis();\n"
-		"  while (millis() - start < 3000) {\n"
-		"    if (client.available() && client.read() == expected) return true;\n"
-		"    delay(10);\n"
+		"  size_t got = 0;\n"
+		"  while (got < len && millis() - start < 3000) {\n"
+		"    if (client.available()) buffer[got++] = client.read();\n"
 		"  }\n"
-		"  return false;\n"
+		"  return got == len;\n"
+		"}\n\n"
+		"uint32_t readUint32(const uint8_t* bytes) {\n"
+		"  return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);\n"
+		"}\n\n"
+		"void putUint32(uint8_t* out, uint32_t value) {\n"
+		"  out[0] = value;\n"
+		"  out[1] = value >> 8;\n"
+		"  out[2] = value >> 16;\n"
+		"  out[3] = value >> 24;\n"
 		"}\n\n"
-		"void sendFile() {\n"
+		"// Paths are sent as a little endian uint16 length followed by the path bytes\n"
+		"bool readPath(WiFiClient& client, char* path, size_t size) {\n"
+		"  uint8_t len[2];\n"
+		"  if (!readExact(client, len, 2)) return false;\n"
+		"  uint16_t pathLen = len[0] | (len[1] << 8);\n"
+		"  if (pathLen >= size || !readExact(client, (uint8_t*)path, pathLen)) return false;\n"
+		"  path[pathLen] = 0;\n"
+		"  return true;\n"
+		"}\n\n"
+		"void sendFile(WiFiClient& client) {\n"
 		"  File file = SD.open(filePath);\n"
 		"  if (!file) {\n"
 		"    client.write(CMD_FAIL);\n"
@@ -151,10 +298,174 @@ arduinoCode::arduinoCode(const wxString& title)
 		"  }\n\n"
 		"  file.close();\n"
 		"  client.write(CMD_SUCCESS);\n"
+		"}\n\n"
+		"void sendSize(WiFiClient& client) {\n"
+		"  char path[128];\n"
+		"  if (!readPath(client, path, sizeof(path))) {\n"
+		"    client.write(CMD_FAIL);\n"
+		"    return;\n"
+		"  }\n"
+		"  File file = SD.open(path);\n"
+		"  if (!file) {\n"
+		"    client.write(CMD_FAIL);\n"
+		"    return;\n"
+		"  }\n"
+		"  uint32_t size = file.size();\n"
+		"  file.close();\n\n"
+		"  uint8_t reply[5] = { CMD_SUCCESS, (uint8_t)size, (uint8_t)(size >> 8), (uint8_t)(size >> 16), (uint8_t)(size >> 24) };\n"
+		"  client.write(reply, sizeof(reply));\n"
+		"}\n\n"
+		"void sendRange(WiFiClient& client) {\n"
+		"  char path[128];\n"
+		"  uint8_t args[8];\n"
+		"  if (!readPath(client, path, sizeof(path)) || !readExact(client, args, sizeof(args))) {\n"
+		"    client.write(CMD_FAIL);\n"
+		"    return;\n"
+		"  }\n"
+		"  uint32_t offset = readUint32(args);\n"
+		"  uint32_t length = readUint32(args + 4);\n\n"
+		"  File file = SD.open(path);\n"
+		"  if (!file || offset + length > file.size() || !file.seek(offset)) {\n"
+		"    client.write(CMD_FAIL);\n"
+		"    return;\n"
+		"  }\n\n"
+		"  client.write(CMD_SUCCESS);\n"
+		"  uint8_t buffer[1024];\n"
+		"  while (length > 0) {\n"
+		"    size_t len = file.read(buffer, min((uint32_t)sizeof(buffer), length));\n"
+		"    if (len == 0) break;\n"
+		"    client.write(buffer, len);\n"
+		"    length -= len;\n"
+		"  }\n"
+		"  file.close();\n"
+		"}\n\n"
+		"void sendListing(WiFiClient& client) {\n"
+		"  char path[128];\n"
+		"  uint8_t args[6];\n"
+		"  if (!readPath(client, path, sizeof(path)) || !readExact(client, args, sizeof(args))) {\n"
+		"    client.write(CMD_FAIL);\n"
+		"    return;\n"
+		"  }\n"
+		"  uint32_t start = readUint32(args);\n"
+		"  uint16_t count = args[4] | (args[5] << 8);\n\n"
+		"  File dir = SD.open(path);\n"
+		"  if (!dir || !dir.isDirectory()) {\n"
+		"    client.write(CMD_FAIL);\n"
+		"    return;\n"
+		"  }\n"
+		"  client.write(CMD_SUCCESS);\n\n"
+		"  uint32_t index = 0;\n"
+		"  for (File entry = dir.openNextFile(); entry && count > 0; entry = dir.openNextFile(), index++) {\n"
+		"    if (index >= start) {\n"
+		"      const char* name = entry.name();\n"
+		"      uint16_t nameLen = strlen(name);\n"
+		"      uint8_t header[11];\n"
+		"      header[0] = entry.isDirectory() ? 1 : 0;\n"
+		"      putUint32(header + 1, entry.size());\n"
+		"      putUint32(header + 5, (uint32_t)entry.getLastWrite());\n"
+		"      header[9] = nameLen;\n"
+		"      header[10] = nameLen >> 8;\n"
+		"      client.write(header, sizeof(header));\n"
+		"      client.write((const uint8_t*)name, nameLen);\n"
+		"      count--;\n"
+		"    }\n"
+		"    entry.close();\n"
+		"  }\n"
+		"  client.write(END_OF_LIST);\n"
+		"  dir.close();\n"
+		"}\n\n"
+		"uint32_t fnv1a(uint32_t hash, const uint8_t* data, size_t len) {\n"
+		"  for (size_t i = 0; i < len; i++) {\n"
+		"    hash ^= data[i];\n"
+		"    hash *= 16777619u;\n"
+		"  }\n"
+		"  return hash;\n"
+		"}\n\n"
+		"// One checksum per page of entries lets the PC refetch only the pages that changed\n"
+		"void sendPageChecksums(WiFiClient& client) {\n"
+		"  char path[128];\n"
+		"  uint8_t pageSize = 0;\n"
+		"  if (!readPath(client, path, sizeof(path)) || !readExact(client, &pageSize, 1) || pageSize == 0) {\n"
+		"    client.write(CMD_FAIL);\n"
+		"    return;\n"
+		"  }\n\n"
+		"  File dir = SD.open(path);\n"
+		"  if (!dir || !dir.isDirectory()) {\n"
+		"    client.write(CMD_FAIL);\n"
+		"    return;\n"
+		"  }\n"
+		"  client.write(CMD_SUCCESS);\n\n"
+		"  uint8_t inPage = 0;\n"
+		"  uint32_t hash = 2166136261u;\n"
+		"  for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {\n"
+		"    const char* name = entry.name();\n"
+		"    uint8_t fields[9];\n"
+		"    fields[0] = entry.isDirectory() ? 1 : 0;\n"
+		"    putUint32(fields + 1, entry.size());\n"
+		"    putUint32(fields + 5, (uint32_t)entry.getLastWrite());\n"
+		"    hash = fnv1a(hash, (const uint8_t*)name, strlen(name));\n"
+		"    hash = fnv1a(hash, fields, sizeof(fields));\n"
+		"    entry.close();\n\n"
+		"    if (++inPage == pageSize) {\n"
+		"      uint8_t page[5] = { inPage };\n"
+		"      putUint32(page + 1, hash);\n"
+		"      client.write(page, sizeof(page));\n"
+		"      inPage = 0;\n"
+		"      hash = 2166136261u;\n"
+		"    }\n"
+		"  }\n"
+		"  if (inPage > 0) {\n"
+		"    uint8_t page[5] = { inPage };\n"
+		"    putUint32(page + 1, hash);\n"
+		"    client.write(page, sizeof(page));\n"
+		"  }\n"
+		"  client.write((uint8_t)0);\n"
+		"  dir.close();\n"
+		"}\n\n"
+		"// RPC frames carry uint32 id, uint16 length and the command text. The id is echoed\n"
+		"// back so the PC can keep several requests in flight and match the replies.\n"
+		"void handleRpc(WiFiClient& client) {\n"
+		"  uint8_t header[6];\n"
+		"  char command[129];\n"
+		"  if (!readExact(client, header, sizeof(header))) return;\n"
+		"  uint16_t len = header[4] | (header[5] << 8);\n"
+		"  size_t keep = min((size_t)len, sizeof(command) - 1);\n"
+		"  if (!readExact(client, (uint8_t*)command, keep)) return;\n"
+		"  for (size_t i = keep; i < len; i++) {\n"
+		"    uint8_t skip;\n"
+		"    readExact(client, &skip, 1);\n"
+		"  }\n"
+		"  command[keep] = 0;\n\n"
+		"  char reply[128];\n"
+		"  bool ok = true;\n"
+		"  if (strcmp(command, \"ping\") == 0) {\n"
+		"    strcpy(reply, \"pong\");\n"
+		"  } else if (strcmp(command, \"uptime\") == 0) {\n"
+		"    snprintf(reply, sizeof(reply), \"%lu\", millis());\n"
+		"  } else if (strcmp(command, \"heap\") == 0) {\n"
+		"    snprintf(reply, sizeof(reply), \"%u\", ESP.getFreeHeap());\n"
+		"  } else if (strncmp(command, \"echo \", 5) == 0) {\n"
+		"    snprintf(reply, sizeof(reply), \"%s\", command + 5);\n"
+		"  } else {\n"
+		"    ok = false;\n"
+		"    strcpy(reply, \"unknown command\");\n"
+		"  }\n\n"
+		"  // Built in one buffer so the reply leaves in a single segment\n"
+		"  uint16_t replyLen = strlen(reply);\n"
+		"  uint8_t frame[8 + sizeof(reply)];\n"
+		"  frame[0] = CMD_RPC;\n"
+		"  memcpy(frame + 1, header, 4);\n"
+		"  frame[5] = ok ? CMD_SUCCESS : CMD_FAIL;\n"
+		"  frame[6] = replyLen;\n"
+		"  frame[7] = replyLen >> 8;\n"
+		"  memcpy(frame + 8, reply, replyLen);\n"
+		"  client.write(frame, 8 + replyLen);\n"
 		"}\n"
 	);
-	wxStaticText* codeLabel = new wxStaticText(panel, wxID_ANY, codeText, wxDefaultPosition, wxSize(560, -1), wxALIGN_LEFT);
-	codeLabel->Wrap(560);
+	// The sketch is too long for a static label, show it scrollable and copyable instead
+	wxTextCtrl* codeLabel = new wxTextCtrl(panel, wxID_ANY, codeText, wxDefaultPosition, wxSize(720, 420),
+		wxTE_MULTILINE | wxTE_READONLY | wxHSCROLL);
+	codeLabel->SetFont(wxFont(wxFontInfo(9).Family(wxFONTFAMILY_TELETYPE)));
 
 	panelSizer->Add(codeLabel, 1, wxALL | wxEXPAND, 10);
 	panel->SetSizer(panelSizer);
@@ -163,6 +474,166 @@ arduinoCode::arduinoCode(const wxString& title)
 	SetSizerAndFit(mainSizer);
 }
 
+captureSearchDialog::captureSearchDialog(const std::string& captureDirectory)
+	: wxDialog(NULL, wxID_ANY, wxString::Format("Search Capture - %s", captureDirectory), wxDefaultPosition, wxSize(800, 650),
+		wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER), directory(captureDirectory)
+{
+	wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
+	wxFlexGridSizer* querySizer = new wxFlexGridSizer(2, 5, 5);
+	querySizer->AddGrowableCol(1);
+
+	patternBox = new wxTextCtrl(this, wxID_ANY, "");
+	regexBox = new wxCheckBox(this, wxID_ANY, "Regular expression");
+	fromBox = new wxTextCtrl(this, wxID_ANY, "");
+	toBox = new wxTextCtrl(this, wxID_ANY, "");
+	fromBox->SetHint("YYYY-MM-DD HH:MM:SS (optional)");
+	toBox->SetHint("YYYY-MM-DD HH:MM:SS (optional)");
+
+	querySizer->Add(new wxStaticText(this, wxID_ANY, "Find:"), 0, wxALIGN_CENTER_VERTICAL);
+	querySizer->Add(patternBox, 1, wxEXPAND);
+	querySizer->AddSpacer(0);
+	querySizer->Add(regexBox);
+	querySizer->Add(new wxStaticText(this, wxID_ANY, "From:"), 0, wxALIGN_CENTER_VERTICAL);
+	querySizer->Add(fromBox, 1, wxEXPAND);
+	querySizer->Add(new wxStaticText(this, wxID_ANY, "To:"), 0, wxALIGN_CENTER_VERTICAL);
+	querySizer->Add(toBox, 1, wxEXPAND);
+
+	wxBoxSizer* buttonSizer = new wxBoxSizer(wxHORIZONTAL);
+	searchButton = new wxButton(this, wxID_FIND, "Search");
+	wxButton* goToButton = new wxButton(this, wxID_ANY, "Go To From Time");
+	buttonSizer->Add(searchButton, 0, wxALL, 5);
+	buttonSizer->Add(goToButton, 0, wxALL, 5);
+
+	resultList = new wxListBox(this, wxID_ANY, wxDefaultPosition, wxSize(780, 250));
+	previewBox = new wxTextCtrl(this, wxID_ANY, "", wxDefaultPosition, wxSize(780, 200), wxTE_MULTILINE | wxTE_READONLY | wxHSCROLL);
+
+	mainSizer->Add(querySizer, 0, wxEXPAND | wxALL, 10);
+	mainSizer->Add(buttonSizer, 0, wxALIGN_CENTER);
+	mainSizer->Add(resultList, 1, wxEXPAND | wxALL, 5);
+	mainSizer->Add(previewBox, 1, wxEXPAND | wxALL, 5);
+	SetSizer(mainSizer);
+
+	searchButton->Bind(wxEVT_BUTTON, &captureSearchDialog::OnSearch, this);
+	goToButton->Bind(wxEVT_BUTTON, &captureSearchDialog::OnGoToTime, this);
+	resultList->Bind(wxEVT_LISTBOX, &captureSearchDialog::OnResultSelected, this);
+}
+
+captureSearchDialog::~captureSearchDialog()
+{
+	// A running search cannot be interrupted, its results are dropped with the dialog
+	if (searchThread.joinable())
+		searchThread.join();
+}
+
+bool captureSearchDialog::openCapture()
+{
+	if (!reader.open(directory))
+	{
+		wxMessageBox("No capture segments found in this directory.", "Capture Error", wxOK | wxICON_ERROR);
+		return false;
+	}
+	return true;
+}
+
+static wxString formatCaptureTime(uint64_t timestampNs)
+{
+	wxDateTime time(wxLongLong(static_cast<wxLongLong_t>(timestampNs / 1000000)));
+	return time.Format("%Y-%m-%d %H:%M:%S.%l");
+}
+
+bool captureSearchDialog::parseTime(wxTextCtrl* box, uint64_t& timestampNs)
+{
+	if (box->IsEmpty()) return true;
+
+	wxDateTime time;
+	if (!time.ParseDateTime(box->GetValue()))
+	{
+		wxMessageBox("Could not parse time: " + box->GetValue(), "Capture Error", wxOK | wxICON_ERROR);
+		return false;
+	}
+	timestampNs = static_cast<uint64_t>(time.GetValue().GetValue()) * 1000000;
+	return true;
+}
+
+void captureSearchDialog::OnSearch(wxCommandEvent& event)
+{
+	uint64_t fromNs = 0;
+	uint64_t toNs = UINT64_MAX;
+	if (!parseTime(fromBox, fromNs) || !parseTime(toBox, toNs))
+		return;
+
+	// The previous search has already posted its results, the button stays disabled until then
+	if (searchThread.joinable())
+		searchThread.join();
+
+	std::string pattern = patternBox->GetValue().ToStdString();
+	bool useRegex = regexBox->IsChecked();
+	searchButton->Disable();
+	previewBox->SetValue("Searching...");
+
+	searchThread = std::thread([this, pattern, useRegex, fromNs, toNs]()
+		{
+			std::vector<captureMatch> found;
+			wxString error;
+			try
+			{
+				found = reader.search(pattern, useRegex, fromNs, toNs, 10000);
+			}
+			catch (const std::exception& e)
+			{
+				error = e.what();
+			}
+
+			CallAfter([this, found = std::move(found), error]()
+				{
+					searchButton->Enable();
+					if (!error.empty())
+					{
+						previewBox->Clear();
+						wxMessageBox("Search Error: " + error, "Capture Error", wxOK | wxICON_ERROR);
+						return;
+					}
+
+					matches = found;
+					wxArrayString lines;
+					for (const auto& match : matches)
+						lines.Add("[" + formatCaptureTime(match.timestampNs) + "] " + wxString::FromUTF8(match.line));
+
+					resultList->Freeze();
+					resultList->Clear();
+					resultList->Append(lines);
+					resultList->Thaw();
+					previewBox->SetValue(wxString::Format("%zu matches", matches.size()));
+				});
+		});
+}
+
+void captureSearchDialog::OnGoToTime(wxCommandEvent& event)
+{
+	uint64_t fromNs = 0;
+	if (!parseTime(fromBox, fromNs))
+		return;
+
+	uint32_t segment = 0;
+	uint64_t offset = 0;
+	if (!reader.seekTime(fromNs, segment, offset))
+	{
+		previewBox->SetValue("Nothing captured at or after that time.");
+		return;
+	}
+	previewBox->SetValue(wxString::FromUTF8(reader.read(segment, offset, 64 * 1024)));
+}
+
+void captureSearchDialog::OnResultSelected(wxCommandEvent& event)
+{
+	int selection = resultList->GetSelection();
+	if (selection == wxNOT_FOUND || selection >= static_cast<int>(matches.size()))
+		return;
+
+	const captureMatch& match = matches[selection];
+	previewBox->SetValue(wxString::FromUTF8(reader.read(match.segment, match.offset, 64 * 1024)));
+}
+
 helpESPfileXfer::helpESPfileXfer(const wxString& title)
 	: wxDialog(NULL, wxID_ANY, title, wxDefaultPosition, wxSize(600, 600))
 {
@@ -179,7 +650,10 @@ helpESPfileXfer::helpESPfileXfer(const wxString& title)
 		" Ctrl + S   : Scan for available COM ports to connect to ESP32 or ESP8266 devices.\n"
 		" Ctrl + D   : Show details of the selected device from the list.\n"
 		" Ctrl + C   : Connect to the selected device via serial communication.\n"
-		" Ctrl + W   : Connect to an ESP32 or ESP8266 device over Wi-Fi by entering the IP address and port.\n"
+		" Ctrl + W   : Connect to an ESP32 or ESP8266 device over Wi-Fi, either a saved device or a new IP address and port.\n"
+		" Ctrl + R   : Replay a recorded WiFi session capture (.espcap) through a WiFi window.\n"
+		" Ctrl + T   : Run a WiFi session capture against the transfer code without a window and check the result.\n"
+		"              The same test runs from a script with: ESPFileXfer --replay-test <capture> [speed]\n"
 		"* Ctrl + Q   : Quit the application.\n"
 		" Ctrl + H   : Open this Help dialog.\n"
 		" Ctrl + K   : Open the Arduino code dialog to view the code used for ESPFileXfer.\n"
@@ -280,6 +754,37 @@ void mainFrame::OnConnect(wxCommandEvent& event)
 
 void mainFrame::OnConnectWiFi(wxCommandEvent& event)
 {
+	// Known devices connect straight to their last address and start from their tuned settings
+	std::vector<deviceProfile> profiles;
+	for (const auto& profile : loadProfiles())
+	{
+		if (!profile.lastIp.empty())
+			profiles.push_back(profile);
+	}
+
+	if (!profiles.empty())
+	{
+		wxArrayString choices;
+		choices.Add("New device...");
+		for (const auto& profile : profiles)
+		{
+			wxString speed = profile.throughput > 0 ? wxString::Format(", %.1f KB/s", profile.throughput / 1024.0) : wxString();
+			choices.Add(wxString::Format("%s  (%s:%s%s)", wxString::FromUTF8(profile.name), profile.lastIp, profile.lastPort, speed));
+		}
+
+		wxSingleChoiceDialog deviceDialog(this, "Choose a device:", "WiFi Connection", choices);
+		if (deviceDialog.ShowModal() != wxID_OK)
+			return;
+
+		if (deviceDialog.GetSelection() > 0)
+		{
+			const deviceProfile& profile = profiles[deviceDialog.GetSelection() - 1];
+			wifiSerialFrame* wifiFrame = new wifiSerialFrame(profile.lastIp, profile.lastPort, profile.name);
+			wifiFrame->Show(true);
+			return;
+		}
+	}
+
 	wxTextEntryDialog ipDialog(this, "Enter Microcontroller IP Address:", "WiFi Connection");
 	if (ipDialog.ShowModal() == wxID_OK)
 	{
@@ -290,12 +795,100 @@ void mainFrame::OnConnectWiFi(wxCommandEvent& event)
 		{
 			std::string port = portDialog.GetValue().ToStdString();
 
-			wifiSerialFrame* wifiFrame = new wifiSerialFrame(ip, port);
+			// Reusing an existing name moves that device to the new address and keeps its tuning
+			wxTextEntryDialog nameDialog(this, "Device name (enter an existing name to update its address):",
+				"WiFi Connection", wxString::Format("%s_%s", ip, port));
+			if (nameDialog.ShowModal() != wxID_OK)
+				return;
+
+			deviceProfile profile = loadProfile(std::string(nameDialog.GetValue().ToUTF8()));
+			profile.lastIp = ip;
+			profile.lastPort = port;
+			saveProfile(profile);
+
+			wifiSerialFrame* wifiFrame = new wifiSerialFrame(ip, port, profile.name);
 			wifiFrame->Show(true);
 		}
 	}
 }
 
+// Asks for a capture and a playback speed, false when the user cancels or the speed is invalid
+static bool chooseCapture(wxWindow* parent, const wxString& title, std::string& path, double& speed)
+{
+	wxFileDialog openFileDialog(
+		parent, "Open Session Capture", "", "",
+		"Session captures (*.espcap)|*.espcap|All files (*.*)|*.*", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+
+	if (openFileDialog.ShowModal() == wxID_CANCEL)
+		return false;
+
+	wxTextEntryDialog speedDialog(parent, "Playback speed (1 = original, 10 = ten times faster, 0 = as fast as possible):", title, "1");
+	if (speedDialog.ShowModal() != wxID_OK)
+		return false;
+
+	speed = 1.0;
+	if (!speedDialog.GetValue().ToDouble(&speed) || speed < 0)
+	{
+		wxMessageBox("Invalid playback speed.", "Replay Error", wxOK | wxICON_ERROR);
+		return false;
+	}
+	path = openFileDialog.GetPath().ToStdString();
+	return true;
+}
+
+void mainFrame::OnReplay(wxCommandEvent& event)
+{
+	std::string capturePath;
+	double speed = 1.0;
+	if (!chooseCapture(this, "Replay Capture", capturePath, speed))
+		return;
+
+	try
+	{
+		// start() loads and checks the capture, so a bad file never gets a window
+		auto replayServer = std::make_shared<sessionReplayServer>(capturePath, speed);
+		unsigned short replayPort = replayServer->start([this](const replayResult& result)
+			{
+				wxTheApp->CallAfter([=]()
+					{
+						if (!result.error.empty())
+							SetStatusText("Replay stopped: " + result.error);
+						else
+							SetStatusText(wxString::Format("Replay finished in %.3f ms from the first host write to closing the window (recorded %.3f ms)",
+								result.replayNs / 1e6, result.recordedNs / 1e6));
+					});
+			});
+
+		wifiSerialFrame* wifiFrame = new wifiSerialFrame("127.0.0.1", std::to_string(replayPort));
+		wifiFrame->Show(true);
+	}
+	catch (const std::exception& e)
+	{
+		wxMessageBox(wxString("Error starting replay: ") + e.what(), "Replay Error", wxOK | wxICON_ERROR);
+	}
+}
+
+void mainFrame::OnReplayTest(wxCommandEvent& event)
+{
+	std::string capturePath;
+	double speed = 1.0;
+	if (!chooseCapture(this, "Replay Test", capturePath, speed))
+		return;
+
+	SetStatusText("Running replay test...");
+
+	// Takes as long as the recorded session at speed 1, keep the UI responsive meanwhile
+	std::thread([this, capturePath, speed]()
+		{
+			replayReport report = sessionReplayTest::run(capturePath, speed);
+			wxTheApp->CallAfter([=]()
+				{
+					SetStatusText(report.passed ? "Replay test passed" : "Replay test failed");
+					wxMessageBox(report.summary(), "Replay Test", wxOK | (report.passed ? wxICON_INFORMATION : wxICON_ERROR));
+				});
+		}).detach();
+}
+
 
 void mainFrame::OnScan(wxCommandEvent& event)
 {
@@ -334,11 +927,19 @@ serialFrame::serialFrame(const std::string& portName)
 	wxButton* extractButton = new wxButton(this, ID_EXTRACT, "Extract");
 	wxButton* exitButton = new wxButton(this, wxID_EXIT, "Exit");
 	wxButton* clearButton = new wxButton(this, wxID_CLEAR, "Clear");
+	recordButton = new wxButton(this, ID_RECORD, "Record");
+	captureButton = new wxButton(this, ID_CAPTURE, "Capture");
+	wxButton* searchButton = new wxButton(this, ID_CAPTURE_SEARCH, "Search Capture");
+	wxButton* baudButton = new wxButton(this, ID_BAUD, "Baud Rate");
 
 	mainSizer->Add(chatLog, 1, wxEXPAND | wxALL, 5);
 	mainSizer->Add(inputBox, 0, wxEXPAND | wxALL, 5);
 	mainSizer->Add(sendButton, 0, wxALIGN_CENTER | wxALL, 5);
 	mainSizer->Add(extractButton, 0, wxALIGN_CENTER | wxALL, 5);
+	mainSizer->Add(recordButton, 0, wxALIGN_CENTER | wxALL, 5);
+	mainSizer->Add(captureButton, 0, wxALIGN_CENTER | wxALL, 5);
+	mainSizer->Add(searchButton, 0, wxALIGN_CENTER | wxALL, 5);
+	mainSizer->Add(baudButton, 0, wxALIGN_CENTER | wxALL, 5);
 	mainSizer->Add(clearButton, 0, wxALIGN_CENTER | wxALL, 5);
 	mainSizer->Add(exitButton, 0, wxALIGN_CENTER | wxALL, 5);
 	SetSizer(mainSizer);
@@ -347,12 +948,22 @@ serialFrame::serialFrame(const std::string& portName)
 	exitButton->Bind(wxEVT_BUTTON, &serialFrame::OnQuit, this);
 	clearButton->Bind(wxEVT_BUTTON, &serialFrame::OnClear, this);
 	extractButton->Bind(wxEVT_BUTTON, &serialFrame::OnExtract, this);
+	recordButton->Bind(wxEVT_BUTTON, &serialFrame::OnRecord, this);
+	captureButton->Bind(wxEVT_BUTTON, &serialFrame::OnCapture, this);
+	searchButton->Bind(wxEVT_BUTTON, &serialFrame::OnSearchCapture, this);
+	baudButton->Bind(wxEVT_BUTTON, &serialFrame::OnBaud, this);
+
+	// Starts at the rate that worked last time, 115200 suits espressif esp32 esp8266 otherwise.
+	// A saved rate is kept as is, garbled text only triggers detection on ports without one.
+	profile = loadProfile("Serial_" + namePort);
+	currentBaudRate = profile.baudRate;
+	baudSettled = profile.baudRateSaved;
 
 	try
 	{
 		ioContext = std::make_unique<asio::io_context>();
 		serialPort = std::make_unique<asio::serial_port>(*ioContext, namePort);
-		serialPort->set_option(asio::serial_port_base::baud_rate(115200)); // intended for espressif esp32 esp8266
+		serialPort->set_option(asio::serial_port_base::baud_rate(currentBaudRate));
 
 		asioListening();
 	}
@@ -372,6 +983,7 @@ void serialFrame::OnSend(wxCommandEvent& event)
 	try
 	{
 		asio::write(*serialPort, asio::buffer(message));
+		recorder.record(captureDirection::WRITE, message.data(), message.size());
 		chatLog->AppendText("You: " + inputBox->GetValue() + "\n");
 		inputBox->Clear();
 	}
@@ -386,6 +998,169 @@ void serialFrame::OnExtract(wxCommandEvent& event)
 	wxMessageBox("Extract not implemented yet!", "Extract", wxOK | wxICON_INFORMATION);
 }
 
+void serialFrame::OnRecord(wxCommandEvent& event)
+{
+	if (recorder.isOpen())
+	{
+		recorder.close();
+		recordButton->SetLabel("Record");
+		return;
+	}
+
+	wxFileDialog saveFileDialog(
+		this, "Save Session Capture", "", "session.espcap",
+		"Session captures (*.espcap)|*.espcap|All files (*.*)|*.*", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+
+	if (saveFileDialog.ShowModal() == wxID_CANCEL)
+		return;
+
+	if (!recorder.open(saveFileDialog.GetPath().ToStdString(), captureTransport::SERIAL))
+	{
+		wxMessageBox("Failed to open capture file for writing.", "Error", wxOK | wxICON_ERROR);
+		return;
+	}
+	recordButton->SetLabel("Stop Recording");
+}
+
+void serialFrame::OnCapture(wxCommandEvent& event)
+{
+	if (serialCapture.isOpen())
+	{
+		uint64_t captured = serialCapture.bytesWritten();
+		serialCapture.close();
+		captureButton->SetLabel("Capture");
+		wxMessageBox(wxString::Format("Captured %llu bytes to %s", static_cast<unsigned long long>(captured), captureDirectory),
+			"Capture", wxOK | wxICON_INFORMATION);
+		return;
+	}
+
+	wxDirDialog dirDialog(this, "Select Capture Directory", "", wxDD_DEFAULT_STYLE);
+	if (dirDialog.ShowModal() == wxID_CANCEL)
+		return;
+
+	captureDirectory = dirDialog.GetPath().ToStdString();
+	if (!serialCapture.open(captureDirectory))
+	{
+		wxMessageBox("Failed to create capture segment.", "Error", wxOK | wxICON_ERROR);
+		return;
+	}
+	captureButton->SetLabel("Stop Capture");
+}
+
+void serialFrame::OnSearchCapture(wxCommandEvent& event)
+{
+	wxDirDialog dirDialog(this, "Select Capture Directory", captureDirectory, wxDD_DEFAULT_STYLE | wxDD_DIR_MUST_EXIST);
+	if (dirDialog.ShowModal() == wxID_CANCEL)
+		return;
+
+	captureSearchDialog* searchDialog = new captureSearchDialog(dirDialog.GetPath().ToStdString());
+	if (!searchDialog->openCapture())
+	{
+		searchDialog->Destroy();
+		return;
+	}
+	searchDialog->Show(true);
+}
+
+void serialFrame::OnBaud(wxCommandEvent& event)
+{
+	wxArrayString choices;
+	int selection = 0;
+	choices.Add("Detect automatically");
+	for (unsigned rate : deviceProfile::BAUD_RATES)
+	{
+		if (rate == currentBaudRate)
+			selection = static_cast<int>(choices.size());
+		choices.Add(wxString::Format("%u", rate));
+	}
+
+	wxSingleChoiceDialog baudDialog(this, "Baud rate for this port:", "Baud Rate", choices);
+	baudDialog.SetSelection(selection);
+	if (baudDialog.ShowModal() != wxID_OK)
+		return;
+
+	// Detection starts over from the current rate and saves the first one that reads as text
+	if (baudDialog.GetSelection() == 0)
+	{
+		baudSettled = false;
+		baudAttempts = 0;
+		baudCheckBytes = 0;
+		baudCheckText = 0;
+		chatLog->AppendText(wxString::Format("\n[Detecting baud rate, starting at %u]\n", currentBaudRate));
+		return;
+	}
+
+	try
+	{
+		setBaudRate(deviceProfile::BAUD_RATES[baudDialog.GetSelection() - 1]);
+	}
+	catch (const std::exception& e)
+	{
+		wxMessageBox(wxString("Error setting baud rate: ") + e.what(), "Serial Error", wxOK | wxICON_ERROR);
+		return;
+	}
+
+	// A manual choice is trusted as is
+	baudSettled = true;
+	profile.baudRate = currentBaudRate;
+	profile.baudRateSaved = true;
+	saveProfile(profile);
+}
+
+void serialFrame::setBaudRate(unsigned baudRate)
+{
+	serialPort->set_option(asio::serial_port_base::baud_rate(baudRate));
+	currentBaudRate = baudRate;
+	baudCheckBytes = 0;
+	baudCheckText = 0;
+	SetTitle(wxString::Format("Serial Communication - %s (%u baud)", namePort, currentBaudRate));
+}
+
+void serialFrame::checkBaudRate(const std::string& data)
+{
+	if (baudSettled)
+		return;
+
+	baudCheckBytes += data.size();
+	baudCheckText += deviceProfile::textByteCount(data.data(), data.size());
+	if (baudCheckBytes < BAUD_CHECK_BYTES)
+		return;
+
+	// Readable text means the rate is right, remember it for the next session
+	if (baudCheckText * 10 >= baudCheckBytes * 9)
+	{
+		baudSettled = true;
+		if (profile.baudRate != currentBaudRate || !profile.baudRateSaved)
+		{
+			profile.baudRate = currentBaudRate;
+			profile.baudRateSaved = true;
+			saveProfile(profile);
+			chatLog->AppendText(wxString::Format("\n[%u baud saved for %s]\n", currentBaudRate, namePort));
+		}
+		return;
+	}
+
+	try
+	{
+		if (++baudAttempts >= std::size(deviceProfile::BAUD_RATES))
+		{
+			baudSettled = true;
+			setBaudRate(profile.baudRate);
+			chatLog->AppendText(wxString::Format("\n[No baud rate gave readable text, staying at %u]\n", currentBaudRate));
+			return;
+		}
+
+		unsigned nextRate = deviceProfile::nextBaudRate(currentBaudRate);
+		chatLog->AppendText(wxString::Format("\n[Data looks garbled at %u baud, trying %u]\n", currentBaudRate, nextRate));
+		setBaudRate(nextRate);
+	}
+	catch (const std::exception& e)
+	{
+		baudSettled = true;
+		wxMessageBox(wxString("Error setting baud rate: ") + e.what(), "Serial Error", wxOK | wxICON_ERROR);
+	}
+}
+
 void serialFrame::OnClear(wxCommandEvent& event)
 {
 	try
@@ -400,6 +1175,8 @@ void serialFrame::OnClear(wxCommandEvent& event)
 
 void serialFrame::OnQuit(wxCommandEvent& event)
 {
+	recorder.close();
+	serialCapture.close();
 	if (serialPort && serialPort->is_open())
 	{
 		serialPort->cancel();
@@ -414,17 +1191,25 @@ void serialFrame::OnQuit(wxCommandEvent& event)
 
 void serialFrame::asioListening()
 {
-	auto buf = std::make_shared<std::array<char, 128>>();
+	auto buf = std::make_shared<std::array<char, 4096>>();
 
 	serialPort->async_read_some(asio::buffer(*buf),
 		[this, buf](const asio::error_code& error, std::size_t len)
 		{
 			if (!error)
 			{
+				// Captured here on the io thread so a busy UI cannot drop data
+				serialCapture.write(buf->data(), len);
+				recorder.record(captureDirection::READ, buf->data(), len);
 				std::string response(buf->data(), len);
 				wxTheApp->CallAfter([=]()
 					{
 						chatLog->AppendText(response);
+						checkBaudRate(response);
+
+						// The capture holds the full stream, keep only the tail on screen
+						if (serialCapture.isOpen() && chatLog->GetLastPosition() > CHATLOG_CAPTURE_LIMIT)
+							chatLog->Remove(0, chatLog->GetLastPosition() - CHATLOG_CAPTURE_LIMIT / 2);
 					});
 
 				// Continue listening
@@ -442,9 +1227,9 @@ void serialFrame::asioListening()
 
 /* ------------------------------------------------------------------------------------------------------------------------------ */
 
-wifiSerialFrame::wifiSerialFrame(const std::string& ipAddress, const std::string& port)
+wifiSerialFrame::wifiSerialFrame(const std::string& ipAddress, const std::string& port, const std::string& profile)
 	: wxFrame(NULL, wxID_ANY, wxString::Format("WiFi Serial Communication - %s:%s", ipAddress, port),
-		wxDefaultPosition, wxSize(800, 650)), serverIp(ipAddress), serverPort(port)
+		wxDefaultPosition, wxSize(800, 650)), serverIp(ipAddress), serverPort(port), profileName(profile)
 {
 	// Create UI components
 	chatLog = new wxTextCtrl(this, wxID_ANY, "", wxDefaultPosition, wxSize(800, 500), wxTE_MULTILINE | wxTE_READONLY);
@@ -453,11 +1238,23 @@ wifiSerialFrame::wifiSerialFrame(const std::string& ipAddress, const std::string
 	wxButton* extractButton = new wxButton(this, ID_EXTRACT, "Extract");
 	wxButton* exitButton = new wxButton(this, wxID_EXIT, "Exit");
 	wxButton* clearButton = new wxButton(this, wxID_CLEAR, "Clear");
+	recordButton = new wxButton(this, ID_RECORD, "Record");
+	wxButton* parallelButton = new wxButton(this, ID_PARALLEL_EXTRACT, "Parallel Extract");
+	wxButton* connectionsButton = new wxButton(this, ID_CONNECTIONS, "Connections");
+	wxButton* browseButton = new wxButton(this, ID_BROWSE, "Browse SD Card");
+	wxButton* rpcButton = new wxButton(this, ID_RPC, "RPC Console");
+	ingestCsvBox = new wxCheckBox(this, wxID_ANY, "Ingest CSV to columnar file on extract");
 
 	mainSizer->Add(chatLog, 1, wxEXPAND | wxALL, 5);
 	mainSizer->Add(inputBox, 0, wxEXPAND | wxALL, 5);
 	mainSizer->Add(sendButton, 0, wxALIGN_CENTER | wxALL, 5);
 	mainSizer->Add(extractButton, 0, wxALIGN_CENTER | wxALL, 5);
+	mainSizer->Add(ingestCsvBox, 0, wxALIGN_CENTER | wxALL, 5);
+	mainSizer->Add(parallelButton, 0, wxALIGN_CENTER | wxALL, 5);
+	mainSizer->Add(connectionsButton, 0, wxALIGN_CENTER | wxALL, 5);
+	mainSizer->Add(browseButton, 0, wxALIGN_CENTER | wxALL, 5);
+	mainSizer->Add(rpcButton, 0, wxALIGN_CENTER | wxALL, 5);
+	mainSizer->Add(recordButton, 0, wxALIGN_CENTER | wxALL, 5);
 	mainSizer->Add(clearButton, 0, wxALIGN_CENTER | wxALL, 5);
 	mainSizer->Add(exitButton, 0, wxALIGN_CENTER | wxALL, 5);
 	SetSizer(mainSizer);
@@ -467,6 +1264,11 @@ wifiSerialFrame::wifiSerialFrame(const std::string& ipAddress, const std::string
 	exitButton->Bind(wxEVT_BUTTON, &wifiSerialFrame::OnQuit, this);
 	clearButton->Bind(wxEVT_BUTTON, &wifiSerialFrame::OnClear, this);
 	extractButton->Bind(wxEVT_BUTTON, &wifiSerialFrame::OnExtract, this);
+	recordButton->Bind(wxEVT_BUTTON, &wifiSerialFrame::OnRecord, this);
+	parallelButton->Bind(wxEVT_BUTTON, &wifiSerialFrame::OnParallelExtract, this);
+	connectionsButton->Bind(wxEVT_BUTTON, &wifiSerialFrame::OnConnections, this);
+	browseButton->Bind(wxEVT_BUTTON, &wifiSerialFrame::OnBrowse, this);
+	rpcButton->Bind(wxEVT_BUTTON, &wifiSerialFrame::OnRpc, this);
 
 	// Attempt to connect to the server
 	try
@@ -496,6 +1298,7 @@ void wifiSerialFrame::OnSend(wxCommandEvent& event)
 	{
 		// Send the message to the server
 		asio::write(*socket, asio::buffer(message));
+		recorder.record(captureDirection::WRITE, message.data(), message.size());
 
 		// Display the sent message in the chat log
 		chatLog->AppendText("You: " + inputBox->GetValue() + "\n");
@@ -529,22 +1332,20 @@ void wifiSerialFrame::OnExtract(wxCommandEvent& event)
 			return;
 		}
 
-		// Handshake
-		char handshakeCmd = static_cast<char>(HANDSHAKE);
-		asio::write(*socket, asio::buffer(&handshakeCmd, 1));
-
-		char response = 0;
-		asio::read(*socket, asio::buffer(&response, 1));
-		if (response != static_cast<char>(HANDSHAKE))
+		// Parse CSV as it streams in rather than re-reading the whole file afterwards
+		std::unique_ptr<csvColumnarWriter> csvIngest;
+		wxFileName columnPath(saveFileDialog.GetPath());
+		columnPath.SetExt("espcol");
+		if (ingestCsvBox->IsChecked())
 		{
-			wxMessageBox("Handshake failed. Extraction aborted.", "Failure", wxOK | wxICON_ERROR);
-			outFile.close();
-			return;
+			csvIngest = std::make_unique<csvColumnarWriter>();
+			if (!csvIngest->open(columnPath.GetFullPath().ToStdString()))
+			{
+				wxMessageBox("Failed to open columnar file for writing.", "Error", wxOK | wxICON_ERROR);
+				return;
+			}
 		}
 
-		char extractCmd = static_cast<char>(EXTRACT);
-		asio::write(*socket, asio::buffer(&extractCmd, 1));
-
 		// Show processing dialog
 		wxDialog processingDialog(this, wxID_ANY, "Processing", wxDefaultPosition, wxSize(300, 100));
 		wxBoxSizer* sizer = new wxBoxSizer(wxVERTICAL);
@@ -554,35 +1355,26 @@ void wifiSerialFrame::OnExtract(wxCommandEvent& event)
 		processingDialog.Show();
 		processingDialog.Update();
 
-		// Blocking read loop until SUCCESS is received
-		char buffer[128];
-		bool foundSuccess = false;
-
-		while (!foundSuccess)
-		{
-			std::size_t len = socket->read_some(asio::buffer(buffer, sizeof(buffer)));
-
-			for (std::size_t i = 0; i < len; ++i)
+		// Same exchange the headless replay test drives, so a capture of this session replays through it
+		deviceProtocol::extractFile(*socket, recorder, [&](const char* data, std::size_t len)
 			{
-				if (static_cast<unsigned char>(buffer[i]) == SUCCESS)
-				{
-					// Write everything before SUCCESS
-					if (i > 0)
-						outFile.write(buffer, i);
-					foundSuccess = true;
-					break;
-				}
-			}
-
-			if (!foundSuccess)
-			{
-				outFile.write(buffer, len);
-			}
-		}
+				outFile.write(data, len);
+				if (csvIngest) csvIngest->feed(data, len);
+			});
 		outFile.flush();
 		outFile.close();
 		processingDialog.Destroy();
-		wxMessageBox("Extraction complete!", "Success", wxOK | wxICON_INFORMATION);
+		if (csvIngest)
+		{
+			if (!csvIngest->finish())
+				wxMessageBox("Failed to write columnar file.", "Error", wxOK | wxICON_ERROR);
+			else
+				wxMessageBox(wxString::Format("Extraction complete!\n%llu rows ingested to %s",
+					static_cast<unsigned long long>(csvIngest->rowCount()), columnPath.GetFullName()),
+					"Success", wxOK | wxICON_INFORMATION);
+		}
+		else
+			wxMessageBox("Extraction complete!", "Success", wxOK | wxICON_INFORMATION);
 
 		// Resume listening
 		asioListeningActive = true;
@@ -590,11 +1382,140 @@ void wifiSerialFrame::OnExtract(wxCommandEvent& event)
 	}
 	catch (const std::exception& e)
 	{
-		if (outFile.is_open()) outFile.close();
 		wxMessageBox(wxString("Exception: ") + e.what(), "Error", wxOK | wxICON_ERROR);
 	}
 }
 
+// Shared by the WiFi window and the remote browser. recorder captures every connection
+// of the download as its own stream, nullptr when nothing is being recorded.
+static void extractRemoteFile(wxWindow* parent, const std::string& profileName,
+	const std::string& ipAddress, const std::string& port, const std::string& remotePath, sessionRecorder* recorder)
+{
+	std::string defaultName = remotePath.substr(remotePath.find_last_of('/') + 1);
+	wxFileDialog saveFileDialog(
+		parent, "Save Extracted File", "", defaultName.empty() ? "extracted.txt" : defaultName,
+		"Text files (*.txt)|*.txt|All files (*.*)|*.*", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+
+	if (saveFileDialog.ShowModal() == wxID_CANCEL)
+		return;
+
+	deviceProfile profile = loadProfile(profileName);
+	if (!profile.capabilitiesKnown)
+	{
+		// Asked once per device, later sessions reuse the stored answer
+		try
+		{
+			deviceLink link(ipAddress, port);
+			link.setRecorder(recorder);
+			link.connect();
+			profile.supportsCompression = (link.capabilities() & deviceLink::CAP_COMPRESSION) != 0;
+			profile.capabilitiesKnown = true;
+			link.close();
+			saveProfile(profile);
+		}
+		catch (const std::exception&)
+		{
+			// Connection problems are reported by the download itself
+		}
+	}
+
+	transferSettings settings = profile.nextTransfer();
+	parallelDownloader downloader(ipAddress, port, remotePath,
+		saveFileDialog.GetPath().ToStdString(), settings.connections, settings.chunkSize);
+	downloader.setRecorder(recorder);
+
+	wxProgressDialog progressDialog("Parallel Extract",
+		wxString::Format("Extracting over %u connections in %u KB chunks, please wait...", settings.connections, settings.chunkSize / 1024),
+		100, parent, wxPD_APP_MODAL | wxPD_CAN_ABORT | wxPD_ELAPSED_TIME | wxPD_REMAINING_TIME);
+
+	std::atomic<uint64_t> done = 0;
+	std::atomic<uint64_t> total = 0;
+	std::atomic<bool> cancel = false;
+	std::atomic<bool> finished = false;
+	std::string error;
+
+	std::thread downloadThread([&]()
+		{
+			try
+			{
+				downloader.run([&](uint64_t doneBytes, uint64_t totalBytes)
+					{
+						done = doneBytes;
+						total = totalBytes;
+						return !cancel;
+					});
+			}
+			catch (const std::exception& e)
+			{
+				error = e.what();
+			}
+			finished = true;
+		});
+
+	// Update() keeps the UI responsive while the connections run on their own threads
+	while (!finished)
+	{
+		int percent = total ? static_cast<int>(done * 100 / total) : 0;
+		if (!progressDialog.Update(std::min(percent, 99)))
+			cancel = true;
+		wxMilliSleep(100);
+	}
+	downloadThread.join();
+	progressDialog.Hide();
+
+	if (!error.empty())
+	{
+		wxMessageBox(wxString("Exception: ") + error, "Error", wxOK | wxICON_ERROR);
+		return;
+	}
+
+	bool reprobe = profile.recordTransfer(settings, downloader.fileSize(), downloader.throughput());
+	saveProfile(profile);
+
+	wxString message = wxString::Format("Extraction complete! %llu bytes at %.1f KB/s",
+		static_cast<unsigned long long>(downloader.fileSize()), downloader.throughput() / 1024.0);
+	if (reprobe)
+		message += "\n\nThroughput fell well below what this device usually reaches, the next transfers will re-tune the link settings.";
+	wxMessageBox(message, "Success", wxOK | wxICON_INFORMATION);
+}
+
+void wifiSerialFrame::OnConnections(wxCommandEvent& event)
+{
+	deviceProfile profile = loadProfile(profileName);
+
+	long value = wxGetNumberFromUser("Number of concurrent connections used by Parallel Extract for this device.",
+		"Connections:", "Parallel Extract", profile.connections, 1, deviceLink::MAX_CONNECTIONS, this);
+	if (value < 1)
+		return;
+
+	// A manual choice ends probing, the next transfer measures it as the new baseline
+	profile.connections = static_cast<unsigned>(value);
+	profile.probing = false;
+	profile.typicalThroughput = 0;
+	saveProfile(profile);
+}
+
+void wifiSerialFrame::OnParallelExtract(wxCommandEvent& event)
+{
+	wxTextEntryDialog pathDialog(this, "Enter remote file path:", "Parallel Extract", "/data.txt");
+	if (pathDialog.ShowModal() != wxID_OK)
+		return;
+
+	extractRemoteFile(this, profileName, serverIp, serverPort, pathDialog.GetValue().ToStdString(), &recorder);
+}
+
+void wifiSerialFrame::OnBrowse(wxCommandEvent& event)
+{
+	remoteBrowserFrame* browser = new remoteBrowserFrame(serverIp, serverPort, profileName);
+	browser->Show(true);
+}
+
+void wifiSerialFrame::OnRpc(wxCommandEvent& event)
+{
+	rpcFrame* console = new rpcFrame(serverIp, serverPort, profileName);
+	console->Show(true);
+}
+
 void wifiSerialFrame::OnClear(wxCommandEvent& event)
 {
 	try
@@ -607,8 +1528,33 @@ void wifiSerialFrame::OnClear(wxCommandEvent& event)
 	}
 }
 
+void wifiSerialFrame::OnRecord(wxCommandEvent& event)
+{
+	if (recorder.isOpen())
+	{
+		recorder.close();
+		recordButton->SetLabel("Record");
+		return;
+	}
+
+	wxFileDialog saveFileDialog(
+		this, "Save Session Capture", "", "session.espcap",
+		"Session captures (*.espcap)|*.espcap|All files (*.*)|*.*", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+
+	if (saveFileDialog.ShowModal() == wxID_CANCEL)
+		return;
+
+	if (!recorder.open(saveFileDialog.GetPath().ToStdString(), captureTransport::WIFI))
+	{
+		wxMessageBox("Failed to open capture file for writing.", "Error", wxOK | wxICON_ERROR);
+		return;
+	}
+	recordButton->SetLabel("Stop Recording");
+}
+
 void wifiSerialFrame::OnQuit(wxCommandEvent& event)
 {
+	recorder.close();
 	if (socket && socket->is_open())
 	{
 		socket->close();
@@ -631,6 +1577,7 @@ void wifiSerialFrame::asioListening()
 		{
 			if (!error)
 			{
+				recorder.record(captureDirection::READ, buf->data(), len);
 				std::string response(buf->data(), len);
 
 				wxTheApp->CallAfter([=]() {
@@ -646,4 +1593,535 @@ void wifiSerialFrame::asioListening()
 					});
 			}
 		});
+}
+
+/* ------------------------------------------------------------------------------------------------------------------------------ */
+
+remoteListCtrl::remoteListCtrl(wxWindow* parent, std::function<wxString(long item, long column)> itemText)
+	: wxListCtrl(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_VIRTUAL | wxLC_SINGLE_SEL), getItemText(itemText)
+{
+	AppendColumn("Name", wxLIST_FORMAT_LEFT, 380);
+	AppendColumn("Size", wxLIST_FORMAT_RIGHT, 120);
+	AppendColumn("Modified", wxLIST_FORMAT_LEFT, 160);
+}
+
+wxString remoteListCtrl::OnGetItemText(long item, long column) const
+{
+	return getItemText(item, column);
+}
+
+remoteBrowserFrame::remoteBrowserFrame(const std::string& ipAddress, const std::string& port, const std::string& profile)
+	: wxFrame(NULL, wxID_ANY, wxString::Format("SD Card Browser - %s:%s", ipAddress, port), wxDefaultPosition, wxSize(700, 650)),
+	serverIp(ipAddress), serverPort(port), profileName(profile), link(ipAddress, port)
+{
+	wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
+	wxBoxSizer* pathSizer = new wxBoxSizer(wxHORIZONTAL);
+
+	pathBox = new wxTextCtrl(this, wxID_ANY, currentDirectory, wxDefaultPosition, wxDefaultSize, wxTE_READONLY);
+	wxButton* upButton = new wxButton(this, wxID_UP, "Up");
+	wxButton* refreshButton = new wxButton(this, wxID_REFRESH, "Refresh");
+	pathSizer->Add(pathBox, 1, wxEXPAND | wxALL, 5);
+	pathSizer->Add(upButton, 0, wxALL, 5);
+	pathSizer->Add(refreshButton, 0, wxALL, 5);
+
+	fileList = new remoteListCtrl(this, [this](long item, long column) { return itemText(item, column); });
+
+	mainSizer->Add(pathSizer, 0, wxEXPAND);
+	mainSizer->Add(fileList, 1, wxEXPAND | wxALL, 5);
+	SetSizer(mainSizer);
+	CreateStatusBar();
+
+	upButton->Bind(wxEVT_BUTTON, &remoteBrowserFrame::OnUp, this);
+	refreshButton->Bind(wxEVT_BUTTON, &remoteBrowserFrame::OnRefresh, this);
+	fileList->Bind(wxEVT_LIST_ITEM_ACTIVATED, &remoteBrowserFrame::OnItemActivated, this);
+
+	index.load(indexPath());
+	workerThread = std::thread([this]() { workerLoop(); });
+	openDirectory(currentDirectory);
+}
+
+remoteBrowserFrame::~remoteBrowserFrame()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		stopWorker = true;
+	}
+	jobReady.notify_all();
+	if (workerThread.joinable())
+		workerThread.join();
+	link.close();
+	index.save(indexPath());
+}
+
+std::string remoteBrowserFrame::indexPath() const
+{
+	wxString directory = wxStandardPaths::Get().GetUserDataDir();
+	wxFileName::Mkdir(directory, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+
+	// Keyed by device so the cache survives DHCP handing out a new address, unnamed sessions fall back to the address
+	if (profileName.empty())
+		return wxString::Format("%s/remote_%s_%s.idx", directory, serverIp, serverPort).ToStdString();
+
+	wxString name = wxString::FromUTF8(profileName);
+	for (wxUniChar c : wxFileName::GetForbiddenChars())
+		name.Replace(wxString(c), "_");
+	return wxString::Format("%s/device_%s.idx", directory, name).ToStdString();
+}
+
+void remoteBrowserFrame::queueJob(std::function<void(deviceLink&)> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		jobs.push_back(std::move(job));
+	}
+	jobReady.notify_one();
+}
+
+void remoteBrowserFrame::workerLoop()
+{
+	bool connected = false;
+	for (;;)
+	{
+		std::function<void(deviceLink&)> job;
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobReady.wait(lock, [this]() { return stopWorker || !jobs.empty(); });
+			if (stopWorker) return;
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		try
+		{
+			if (!connected)
+			{
+				link.connect();
+				connected = true;
+			}
+			job(link);
+		}
+		catch (const std::exception& e)
+		{
+			link.close();
+			connected = false;
+			wxString message(e.what());
+			CallAfter([this, message]()
+				{
+					pendingPages.clear();
+					SetStatusText("Device error: " + message);
+				});
+		}
+	}
+}
+
+void remoteBrowserFrame::openDirectory(const std::string& directory)
+{
+	currentDirectory = directory;
+	pathBox->SetValue(directory);
+	openStart = std::chrono::steady_clock::now();
+
+	// Show whatever is cached straight away, the device is only asked if it changed
+	remoteListing* listing = index.find(directory);
+	fileList->SetItemCount(listing ? listing->total : 0);
+	fileList->Refresh();
+	SetStatusText(listing ? wxString::Format("%u entries (cached), checking for changes...", listing->total) : wxString("Listing..."));
+
+	queueJob([this, directory](deviceLink& link)
+		{
+			uint32_t total = 0;
+			std::vector<uint32_t> checksums = link.pageChecksums(directory, remoteIndex::LISTING_PAGE_SIZE, total);
+
+			CallAfter([this, directory, total, checksums]()
+				{
+					uint32_t stale = index.applyChecksums(directory, total, checksums);
+					if (directory != currentDirectory)
+						return;
+
+					// Only the pages that changed are refetched, and only once they are drawn
+					double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - openStart).count();
+					fileList->SetItemCount(total);
+					fileList->Refresh();
+					SetStatusText(wxString::Format("%u entries, %u of %u pages changed, checked in %.0f ms",
+						total, stale, static_cast<unsigned>(checksums.size()), elapsedMs));
+				});
+		});
+}
+
+void remoteBrowserFrame::requestPage(uint32_t page)
+{
+	auto key = std::make_pair(currentDirectory, page);
+	if (pendingPages.count(key))
+		return;
+	pendingPages.insert(key);
+
+	std::string directory = currentDirectory;
+	queueJob([this, directory, page](deviceLink& link)
+		{
+			std::vector<remoteEntry> entries = link.listDirectory(directory, page * remoteIndex::LISTING_PAGE_SIZE, remoteIndex::LISTING_PAGE_SIZE);
+
+			CallAfter([this, directory, page, entries]()
+				{
+					std::vector<remoteEntry> pageEntries = entries;
+					pendingPages.erase(std::make_pair(directory, page));
+					index.applyPage(directory, page, pageEntries);
+
+					remoteListing* listing = index.find(directory);
+					if (directory != currentDirectory || !listing || listing->total == 0)
+						return;
+
+					long first = page * remoteIndex::LISTING_PAGE_SIZE;
+					long last = std::min<long>(first + remoteIndex::LISTING_PAGE_SIZE, listing->total) - 1;
+					if (first <= last)
+						fileList->RefreshItems(first, last);
+				});
+		});
+}
+
+wxString remoteBrowserFrame::itemText(long item, long column)
+{
+	remoteListing* listing = index.find(currentDirectory);
+	if (!listing || item < 0 || item >= static_cast<long>(listing->total))
+		return "";
+
+	// Pages are only fetched once the list actually asks to draw them
+	uint32_t page = static_cast<uint32_t>(item) / remoteIndex::LISTING_PAGE_SIZE;
+	if (!listing->pageValid[page])
+		requestPage(page);
+
+	const remoteEntry& entry = listing->entries[item];
+	if (entry.name.empty())
+		return column == 0 ? "Loading..." : "";
+
+	switch (column)
+	{
+	case 0:
+		return wxString::FromUTF8(entry.name) + (entry.isDirectory ? "/" : "");
+	case 1:
+		return entry.isDirectory ? wxString() : wxFileName::GetHumanReadableSize(wxULongLong(entry.size));
+	case 2:
+		return entry.modified ? wxDateTime(static_cast<time_t>(entry.modified)).Format("%Y-%m-%d %H:%M") : wxString();
+	default:
+		return "";
+	}
+}
+
+void remoteBrowserFrame::OnItemActivated(wxListEvent& event)
+{
+	remoteListing* listing = index.find(currentDirectory);
+	long item = event.GetIndex();
+	if (!listing || item < 0 || item >= static_cast<long>(listing->total) || listing->entries[item].name.empty())
+		return;
+
+	const remoteEntry& entry = listing->entries[item];
+	std::string path = currentDirectory + (currentDirectory.back() == '/' ? "" : "/") + entry.name;
+	if (entry.isDirectory)
+		openDirectory(path);
+	else
+		extractRemoteFile(this, profileName, serverIp, serverPort, path, nullptr);
+}
+
+void remoteBrowserFrame::OnUp(wxCommandEvent& event)
+{
+	if (currentDirectory == "/")
+		return;
+
+	std::size_t slash = currentDirectory.find_last_of('/');
+	openDirectory(slash == 0 ? "/" : currentDirectory.substr(0, slash));
+}
+
+void remoteBrowserFrame::OnRefresh(wxCommandEvent& event)
+{
+	index.invalidate(currentDirectory);
+	openDirectory(currentDirectory);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------------------ */
+
+static wxString formatMicros(uint64_t micros)
+{
+	if (micros < 1000)
+		return wxString::Format("%llu us", static_cast<unsigned long long>(micros));
+	if (micros < 1000000)
+		return wxString::Format("%.2f ms", micros / 1000.0);
+	return wxString::Format("%.2f s", micros / 1000000.0);
+}
+
+rpcFrame::rpcFrame(const std::string& ipAddress, const std::string& port, const std::string& profile)
+	: wxFrame(NULL, wxID_ANY, wxString::Format("RPC Console - %s:%s", ipAddress, port), wxDefaultPosition, wxSize(800, 700)),
+	channel(ipAddress, port), profileName(profile), refreshTimer(this)
+{
+	wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
+	wxBoxSizer* inputSizer = new wxBoxSizer(wxHORIZONTAL);
+	wxBoxSizer* buttonSizer = new wxBoxSizer(wxHORIZONTAL);
+
+	inputBox = new wxTextCtrl(this, wxID_ANY, "", wxDefaultPosition, wxDefaultSize, wxTE_PROCESS_ENTER);
+	wxButton* sendButton = new wxButton(this, ID_SEND, "Send");
+	inputSizer->Add(inputBox, 1, wxEXPAND | wxALL, 5);
+	inputSizer->Add(sendButton, 0, wxALL, 5);
+
+	replyLog = new wxTextCtrl(this, wxID_ANY, "", wxDefaultPosition, wxSize(800, 200), wxTE_MULTILINE | wxTE_READONLY);
+
+	statsList = new wxListCtrl(this, wxID_ANY, wxDefaultPosition, wxSize(800, 150), wxLC_REPORT | wxLC_SINGLE_SEL);
+	statsList->AppendColumn("Command", wxLIST_FORMAT_LEFT, 160);
+	statsList->AppendColumn("Count", wxLIST_FORMAT_RIGHT, 80);
+	statsList->AppendColumn("Failed", wxLIST_FORMAT_RIGHT, 70);
+	statsList->AppendColumn("Min", wxLIST_FORMAT_RIGHT, 90);
+	statsList->AppendColumn("p50", wxLIST_FORMAT_RIGHT, 90);
+	statsList->AppendColumn("p90", wxLIST_FORMAT_RIGHT, 90);
+	statsList->AppendColumn("p99", wxLIST_FORMAT_RIGHT, 90);
+	statsList->AppendColumn("Max", wxLIST_FORMAT_RIGHT, 90);
+
+	histogramBox = new wxTextCtrl(this, wxID_ANY, "", wxDefaultPosition, wxSize(800, 180), wxTE_MULTILINE | wxTE_READONLY | wxTE_DONTWRAP);
+	histogramBox->SetFont(wxFont(wxFontInfo(9).Family(wxFONTFAMILY_TELETYPE)));
+
+	scriptButton = new wxButton(this, ID_RPC_SCRIPT, "Run Script");
+	windowBox = new wxSpinCtrl(this, wxID_ANY, "", wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 1, rpcChannel::MAX_WINDOW,
+		loadProfile(profileName).rpcWindow);
+	wxButton* exportButton = new wxButton(this, ID_RPC_EXPORT, "Export CSV");
+	wxButton* resetButton = new wxButton(this, wxID_CLEAR, "Reset");
+	reconnectButton = new wxButton(this, ID_RPC_RECONNECT, "Reconnect");
+	reconnectButton->Disable();
+	buttonSizer->Add(scriptButton, 0, wxALL, 5);
+	buttonSizer->Add(new wxStaticText(this, wxID_ANY, "In flight:"), 0, wxALIGN_CENTER_VERTICAL | wxLEFT, 5);
+	buttonSizer->Add(windowBox, 0, wxALL, 5);
+	buttonSizer->Add(exportButton, 0, wxALL, 5);
+	buttonSizer->Add(resetButton, 0, wxALL, 5);
+	buttonSizer->Add(reconnectButton, 0, wxALL, 5);
+
+	mainSizer->Add(inputSizer, 0, wxEXPAND);
+	mainSizer->Add(replyLog, 1, wxEXPAND | wxALL, 5);
+	mainSizer->Add(statsList, 1, wxEXPAND | wxALL, 5);
+	mainSizer->Add(histogramBox, 1, wxEXPAND | wxALL, 5);
+	mainSizer->Add(buttonSizer, 0, wxALIGN_CENTER);
+	SetSizer(mainSizer);
+	CreateStatusBar();
+
+	sendButton->Bind(wxEVT_BUTTON, &rpcFrame::OnSend, this);
+	inputBox->Bind(wxEVT_TEXT_ENTER, &rpcFrame::OnSend, this);
+	scriptButton->Bind(wxEVT_BUTTON, &rpcFrame::OnRunScript, this);
+	exportButton->Bind(wxEVT_BUTTON, &rpcFrame::OnExport, this);
+	resetButton->Bind(wxEVT_BUTTON, &rpcFrame::OnReset, this);
+	reconnectButton->Bind(wxEVT_BUTTON, &rpcFrame::OnReconnect, this);
+	statsList->Bind(wxEVT_LIST_ITEM_SELECTED, &rpcFrame::OnCommandSelected, this);
+	Bind(wxEVT_TIMER, &rpcFrame::OnRefreshTimer, this);
+
+	try
+	{
+		channel.connect();
+	}
+	catch (const std::exception& e)
+	{
+		wxMessageBox(wxString("Error opening RPC connection: ") + e.what(), "RPC Error", wxOK | wxICON_ERROR);
+		this->Close(true);
+		return;
+	}
+	wasConnected = true;
+	refreshTimer.Start(500);
+}
+
+rpcFrame::~rpcFrame()
+{
+	refreshTimer.Stop();
+	channel.close();
+}
+
+void rpcFrame::OnSend(wxCommandEvent& event)
+{
+	std::string command = inputBox->GetValue().ToStdString();
+	if (command.empty())
+		return;
+
+	uint32_t id = channel.call(command, [this](const rpcResult& result)
+		{
+			CallAfter([this, result]()
+				{
+					replyLog->AppendText(wxString::Format("#%u %s %s (%s)\n", result.id, result.ok ? "<" : "!",
+						wxString::FromUTF8(result.reply), formatMicros(static_cast<uint64_t>(result.rtt.count()))));
+				});
+		});
+
+	replyLog->AppendText(wxString::Format("#%u > %s\n", id, inputBox->GetValue()));
+	inputBox->Clear();
+}
+
+void rpcFrame::OnRunScript(wxCommandEvent& event)
+{
+	if (scriptRunning)
+	{
+		channel.cancelScript();
+		scriptButton->Disable();
+		return;
+	}
+
+	wxFileDialog openFileDialog(this, "Open Command Script", "", "",
+		"Text files (*.txt)|*.txt|All files (*.*)|*.*", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+
+	if (openFileDialog.ShowModal() == wxID_CANCEL)
+		return;
+
+	// One command per line, blank lines and lines starting with # are skipped
+	std::ifstream scriptFile(openFileDialog.GetPath().ToStdString());
+	std::vector<std::string> commands;
+	std::string line;
+	while (std::getline(scriptFile, line))
+	{
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (!line.empty() && line[0] != '#')
+			commands.push_back(line);
+	}
+	if (commands.empty())
+	{
+		wxMessageBox("The script does not contain any commands.", "RPC Error", wxOK | wxICON_ERROR);
+		return;
+	}
+
+	long repeat = wxGetNumberFromUser(wxString::Format("%llu commands loaded. Run the script how many times?", static_cast<unsigned long long>(commands.size())),
+		"Repeat:", "Run Script", 1, 1, 1000000, this);
+	if (repeat < 1)
+		return;
+
+	deviceProfile profile = loadProfile(profileName);
+	profile.rpcWindow = static_cast<unsigned>(windowBox->GetValue());
+	saveProfile(profile);
+
+	scriptRunning = true;
+	scriptButton->SetLabel("Stop Script");
+	SetStatusText(wxString::Format("Running %llu requests...", static_cast<unsigned long long>(commands.size()) * repeat));
+
+	channel.runScript(commands, static_cast<uint64_t>(repeat), static_cast<unsigned>(windowBox->GetValue()),
+		[this](const scriptSummary& summary)
+		{
+			CallAfter([this, summary]()
+				{
+					scriptRunning = false;
+					scriptButton->SetLabel("Run Script");
+					scriptButton->Enable();
+					if (!summary.error.empty())
+					{
+						SetStatusText(wxString::Format("Script failed after %llu requests: %s",
+							static_cast<unsigned long long>(summary.completed), wxString::FromUTF8(summary.error)));
+						return;
+					}
+					SetStatusText(wxString::Format("Script %s: %llu requests, %llu failed, %.2f s, %.0f requests/s",
+						summary.cancelled ? "stopped" : "finished",
+						static_cast<unsigned long long>(summary.completed), static_cast<unsigned long long>(summary.failures),
+						summary.seconds, summary.seconds > 0 ? summary.completed / summary.seconds : 0.0));
+				});
+		});
+}
+
+void rpcFrame::OnExport(wxCommandEvent& event)
+{
+	wxFileDialog saveFileDialog(
+		this, "Export Latency Histograms", "", "rtt.csv",
+		"CSV files (*.csv)|*.csv|All files (*.*)|*.*", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+
+	if (saveFileDialog.ShowModal() == wxID_CANCEL)
+		return;
+
+	if (!channel.exportCsv(saveFileDialog.GetPath().ToStdString()))
+		wxMessageBox("Failed to write the CSV file.", "Error", wxOK | wxICON_ERROR);
+}
+
+void rpcFrame::OnReset(wxCommandEvent& event)
+{
+	channel.resetHistograms();
+	replyLog->Clear();
+	statsList->DeleteAllItems();
+	histogramBox->Clear();
+}
+
+void rpcFrame::OnCommandSelected(wxListEvent& event)
+{
+	selectedCommand = statsList->GetItemText(event.GetIndex()).ToStdString();
+	showHistogram(channel.histograms());
+}
+
+void rpcFrame::OnRefreshTimer(wxTimerEvent& event)
+{
+	std::map<std::string, rttHistogram> histograms = channel.histograms();
+
+	// Rows are updated in place so the selection survives a refresh
+	long row = 0;
+	for (const auto& item : histograms)
+	{
+		const rttHistogram& histogram = item.second;
+		if (row >= statsList->GetItemCount())
+			statsList->InsertItem(row, "");
+
+		statsList->SetItem(row, 0, wxString::FromUTF8(item.first));
+		statsList->SetItem(row, 1, wxString::Format("%llu", static_cast<unsigned long long>(histogram.count)));
+		statsList->SetItem(row, 2, wxString::Format("%llu", static_cast<unsigned long long>(histogram.failures)));
+		statsList->SetItem(row, 3, histogram.count ? formatMicros(histogram.minMicros) : wxString("-"));
+		statsList->SetItem(row, 4, histogram.count ? formatMicros(histogram.percentile(0.50)) : wxString("-"));
+		statsList->SetItem(row, 5, histogram.count ? formatMicros(histogram.percentile(0.90)) : wxString("-"));
+		statsList->SetItem(row, 6, histogram.count ? formatMicros(histogram.percentile(0.99)) : wxString("-"));
+		statsList->SetItem(row, 7, histogram.count ? formatMicros(histogram.maxMicros) : wxString("-"));
+		++row;
+	}
+	while (statsList->GetItemCount() > row)
+		statsList->DeleteItem(statsList->GetItemCount() - 1);
+
+	showHistogram(histograms);
+	if (scriptRunning)
+		SetStatusText(wxString::Format("Script running, %llu requests in flight", static_cast<unsigned long long>(channel.inFlight())));
+
+	// Reported once when the connection drops, the console stays usable after a reconnect
+	bool connected = channel.connected();
+	if (wasConnected && !connected)
+		SetStatusText("Connection lost: " + wxString::FromUTF8(channel.lastError()) + ", press Reconnect to continue");
+	reconnectButton->Enable(!connected);
+	wasConnected = connected;
+}
+
+void rpcFrame::OnReconnect(wxCommandEvent& event)
+{
+	if (channel.connected())
+		return;
+
+	try
+	{
+		wxBusyCursor busy;
+		channel.connect();
+	}
+	catch (const std::exception& e)
+	{
+		SetStatusText(wxString("Reconnect failed: ") + e.what());
+		return;
+	}
+	wasConnected = true;
+	reconnectButton->Disable();
+	replyLog->AppendText("[Reconnected]\n");
+	SetStatusText("Reconnected");
+}
+
+void rpcFrame::showHistogram(const std::map<std::string, rttHistogram>& histograms)
+{
+	auto it = histograms.find(selectedCommand);
+	if (it == histograms.end())
+		it = histograms.begin();
+	if (it == histograms.end() || it->second.count == 0)
+	{
+		histogramBox->Clear();
+		return;
+	}
+
+	const rttHistogram& histogram = it->second;
+	int first = 0;
+	int last = rttHistogram::BUCKETS - 1;
+	while (histogram.buckets[first] == 0) ++first;
+	while (histogram.buckets[last] == 0) --last;
+
+	uint64_t peak = *std::max_element(histogram.buckets + first, histogram.buckets + last + 1);
+	wxString text = wxString::Format("%s: %llu samples, mean %s\n", wxString::FromUTF8(it->first),
+		static_cast<unsigned long long>(histogram.count), formatMicros(static_cast<uint64_t>(histogram.meanMicros())));
+	for (int bucket = first; bucket <= last; ++bucket)
+	{
+		int width = static_cast<int>(histogram.buckets[bucket] * 50 / peak);
+		text += wxString::Format("< %10s |%-50s %llu\n", formatMicros(rttHistogram::bucketUpperMicros(bucket)),
+			wxString('#', width), static_cast<unsigned long long>(histogram.buckets[bucket]));
+	}
+
+	if (histogramBox->GetValue() != text)
+		histogramBox->ChangeValue(text);
 }
\ No newline at end of file
@@ -22,6 +22,24 @@ Date of Last Implementation: 2025-04-21 , YYYY-MM-DD
 #include "fstream"
 #include "wx/progdlg.h"
 #include "wx/filedlg.h"
+#include "wx/config.h"
+#include "wx/numdlg.h"
+#include "wx/listctrl.h"
+#include "wx/stdpaths.h"
+#include "wx/filename.h"
+#include "wx/spinctrl.h"
+#include "set"
+#include "deque"
+#include "condition_variable"
+#include "functional"
+#include "capture.h"
+#include "replaytest.h"
+#include "serialcapture.h"
+#include "paralleldownload.h"
+#include "remoteindex.h"
+#include "csvingest.h"
+#include "rpcchannel.h"
+#include "deviceprofile.h"
 
 using asio::ip::tcp;
 
@@ -29,6 +47,9 @@ class ESPFileXfer : public wxApp
 {
 public:
 	virtual bool OnInit();
+	virtual int OnRun();
+private:
+	int replayTestExitCode = -1;	// set when started with --replay-test, no window is opened
 };
 
 class mainFrame : public wxFrame
@@ -44,6 +65,8 @@ private:
 	void OnConnectWiFi(wxCommandEvent& event);
 	void OnDetail(wxCommandEvent& event);
 	void OnCode(wxCommandEvent& event);
+	void OnReplay(wxCommandEvent& event);
+	void OnReplayTest(wxCommandEvent& event);
 	wxPanel* mainPanel;
 	wxBoxSizer* mainSizer;
 	std::vector<std::pair<wxCheckBox*, std::string>> deviceList;
@@ -73,6 +96,36 @@ public:
 	arduinoCode(const wxString& title);
 };
 
+class captureSearchDialog : public wxDialog
+{
+public:
+	captureSearchDialog(const std::string& captureDirectory);
+	~captureSearchDialog();
+
+	// Reports a missing or unreadable capture, the dialog should not be shown then
+	bool openCapture();
+private:
+	void OnSearch(wxCommandEvent& event);
+	void OnGoToTime(wxCommandEvent& event);
+	void OnResultSelected(wxCommandEvent& event);
+	bool parseTime(wxTextCtrl* box, uint64_t& timestampNs);
+
+	std::string directory;
+	serialCaptureReader reader;
+	std::vector<captureMatch> matches;
+
+	// Searches run on their own thread so gigabytes of capture do not freeze the dialog
+	std::thread searchThread;
+
+	wxTextCtrl* patternBox;
+	wxCheckBox* regexBox;
+	wxTextCtrl* fromBox;
+	wxTextCtrl* toBox;
+	wxListBox* resultList;
+	wxTextCtrl* previewBox;
+	wxButton* searchButton;
+};
+
 class serialFrame : public wxFrame
 {
 public:
@@ -82,21 +135,41 @@ private:
 	void OnQuit(wxCommandEvent& event);
 	void OnSend(wxCommandEvent& event);
 	void OnExtract(wxCommandEvent& event);
+	void OnRecord(wxCommandEvent& event);
+	void OnCapture(wxCommandEvent& event);
+	void OnSearchCapture(wxCommandEvent& event);
+	void OnBaud(wxCommandEvent& event);
+	void setBaudRate(unsigned baudRate);
+	void checkBaudRate(const std::string& data);
 	void asioListening();
 
 	std::string namePort;
+	deviceProfile profile;
+	unsigned currentBaudRate = deviceProfile::DEFAULT_BAUD_RATE;
+	std::size_t baudCheckBytes = 0;
+	std::size_t baudCheckText = 0;
+	unsigned baudAttempts = 0;
+	bool baudSettled = false;
 	std::unique_ptr<asio::io_context> ioContext;
 	std::unique_ptr<asio::serial_port> serialPort;
+	sessionRecorder recorder;
+	serialCaptureWriter serialCapture;
+	std::string captureDirectory;
 
 	wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
 	wxTextCtrl* inputBox;
 	wxTextCtrl* chatLog;
+	wxButton* recordButton;
+	wxButton* captureButton;
+
+	const long CHATLOG_CAPTURE_LIMIT = 256 * 1024;
+	const std::size_t BAUD_CHECK_BYTES = 256;
 };
 
 class wifiSerialFrame : public wxFrame
 {
 public:
-	wifiSerialFrame(const std::string& ipAddress, const std::string& port);
+	wifiSerialFrame(const std::string& ipAddress, const std::string& port, const std::string& profile = "");
 
 private:
 	void OnClear(wxCommandEvent& event);
@@ -104,6 +177,11 @@ private:
 	void OnSend(wxCommandEvent& event);
 	void OnExtract(wxCommandEvent& event);
 	void OnExtractTimer(wxTimerEvent& event);
+	void OnRecord(wxCommandEvent& event);
+	void OnParallelExtract(wxCommandEvent& event);
+	void OnConnections(wxCommandEvent& event);
+	void OnBrowse(wxCommandEvent& event);
+	void OnRpc(wxCommandEvent& event);
 	void asioListening();
 	//void cancelListening();
 
@@ -111,6 +189,7 @@ private:
 
 	std::string serverIp;
 	std::string serverPort;
+	std::string profileName;
 
 	std::unique_ptr<asio::io_context> ioContext;
 	std::unique_ptr<asio::ip::tcp::socket> socket;
@@ -118,6 +197,7 @@ private:
 	std::unique_ptr<std::ofstream> extractFileStream;
 	std::unique_ptr<wxProgressDialog> extractProgressDialog;
 	std::ofstream outFile;
+	sessionRecorder recorder;
 	/*wxDialog* processingDialog = nullptr;
 	wxTimer* extractionTimer = nullptr;
 	bool extractionInProgress = false;*/
@@ -125,11 +205,87 @@ private:
 	wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
 	wxTextCtrl* inputBox;
 	wxTextCtrl* chatLog;
+	wxButton* recordButton;
+	wxCheckBox* ingestCsvBox;
+};
+
+class remoteListCtrl : public wxListCtrl
+{
+public:
+	remoteListCtrl(wxWindow* parent, std::function<wxString(long item, long column)> itemText);
+	wxString OnGetItemText(long item, long column) const override;
+private:
+	std::function<wxString(long, long)> getItemText;
+};
+
+class remoteBrowserFrame : public wxFrame
+{
+public:
+	remoteBrowserFrame(const std::string& ipAddress, const std::string& port, const std::string& profile);
+	~remoteBrowserFrame();
+
+private:
+	void OnItemActivated(wxListEvent& event);
+	void OnUp(wxCommandEvent& event);
+	void OnRefresh(wxCommandEvent& event);
+	void openDirectory(const std::string& directory);
+	void requestPage(uint32_t page);
+	wxString itemText(long item, long column);
+	void queueJob(std::function<void(deviceLink&)> job);
+	void workerLoop();
+	std::string indexPath() const;
+
+	std::string serverIp;
+	std::string serverPort;
+	std::string profileName;
+	std::string currentDirectory = "/";
+	remoteIndex index;
+	std::set<std::pair<std::string, uint32_t>> pendingPages;
+	std::chrono::steady_clock::time_point openStart;
+
+	// All device traffic for the browser runs on one worker thread with its own connection
+	deviceLink link;
+	std::thread workerThread;
+	std::mutex jobMutex;
+	std::condition_variable jobReady;
+	std::deque<std::function<void(deviceLink&)>> jobs;
+	bool stopWorker = false;
+
+	wxTextCtrl* pathBox;
+	remoteListCtrl* fileList;
+};
 
-	const uint8_t EXTRACT = 0x00;
-	const uint8_t HANDSHAKE = 0x01;
-	const uint8_t FAILURE = 0x02;
-	const uint8_t SUCCESS = 0x03;
+class rpcFrame : public wxFrame
+{
+public:
+	rpcFrame(const std::string& ipAddress, const std::string& port, const std::string& profile);
+	~rpcFrame();
+
+private:
+	void OnSend(wxCommandEvent& event);
+	void OnRunScript(wxCommandEvent& event);
+	void OnExport(wxCommandEvent& event);
+	void OnReset(wxCommandEvent& event);
+	void OnCommandSelected(wxListEvent& event);
+	void OnRefreshTimer(wxTimerEvent& event);
+	void OnReconnect(wxCommandEvent& event);
+	void showHistogram(const std::map<std::string, rttHistogram>& histograms);
+
+	// Replies arrive on the channel's io thread and are marshalled back with CallAfter
+	rpcChannel channel;
+	std::string profileName;
+	std::string selectedCommand;
+	bool scriptRunning = false;
+	bool wasConnected = false;
+	wxTimer refreshTimer;
+
+	wxTextCtrl* inputBox;
+	wxTextCtrl* replyLog;
+	wxListCtrl* statsList;
+	wxTextCtrl* histogramBox;
+	wxSpinCtrl* windowBox;
+	wxButton* scriptButton;
+	wxButton* reconnectButton;
 };
 
 
@@ -142,7 +298,20 @@ enum externalID
 	ID_DEVICE_WIFI,
 	ID_SEND,
 	ID_EXTRACT,
-	ID_CODE
+	ID_CODE,
+	ID_RECORD,
+	ID_REPLAY,
+	ID_REPLAY_TEST,
+	ID_CAPTURE,
+	ID_CAPTURE_SEARCH,
+	ID_PARALLEL_EXTRACT,
+	ID_CONNECTIONS,
+	ID_BROWSE,
+	ID_RPC,
+	ID_RPC_SCRIPT,
+	ID_RPC_EXPORT,
+	ID_RPC_RECONNECT,
+	ID_BAUD
 };
 
 #endif// _GUI_H_
\ No newline at end of file
@@ -15,8 +15,33 @@ wxDECLARE_APP(ESPFileXfer);
 
 bool ESPFileXfer::OnInit()
 {
+	// ESPFileXfer --replay-test <capture> [speed] checks a capture against the transfer code
+	// and exits with 0 when it passes, so regressions can be caught from a script
+	if (argc >= 3 && argv[1] == "--replay-test")
+	{
+		double speed = 1.0;
+		if (argc >= 4 && (!argv[3].ToDouble(&speed) || speed < 0))
+		{
+			std::cerr << "Invalid playback speed: " << argv[3].ToStdString() << std::endl;
+			replayTestExitCode = 2;
+			return true;
+		}
+
+		replayReport report = sessionReplayTest::run(argv[2].ToStdString(), speed);
+		std::cout << report.summary();
+		replayTestExitCode = report.passed ? 0 : 1;
+		return true;
+	}
+
 	mainFrame* frame = new mainFrame("ESPFilexfer");
 	frame->SetSizeHints(400, -1, 400, -1);
 	frame -> Show(true);
 	return true;
+}
+
+int ESPFileXfer::OnRun()
+{
+	if (replayTestExitCode >= 0)
+		return replayTestExitCode;
+	return wxApp::OnRun();
 }
\ No newline at end of file
@@ -0,0 +1,222 @@
+/*
+Program: ESPFileXfer
+File: paralleldownload.cpp
+Author: Listerine-debug
+Description: This file contains the implementation of multi-connection range downloads
+for ESPFileXfer.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+#include "paralleldownload.h"
+#include "fstream"
+#include "filesystem"
+#include "thread"
+#include "chrono"
+#include "stdexcept"
+#include "algorithm"
+
+static const std::size_t NO_RANGE = static_cast<std::size_t>(-1);
+
+parallelDownloader::parallelDownloader(const std::string& ipAddress, const std::string& port,
+	const std::string& remotePath, const std::string& localPath,
+	unsigned connections, uint32_t chunkSize)
+	: serverIp(ipAddress), serverPort(port), remoteFile(remotePath), localFile(localPath),
+	connectionCount(std::min(std::max(connections, 1u), deviceLink::MAX_CONNECTIONS)), pieceSize(std::max<uint32_t>(chunkSize, 1024))
+{
+}
+
+void parallelDownloader::setError(const std::string& error)
+{
+	std::lock_guard<std::mutex> lock(errorMutex);
+	lastError = error;
+}
+
+bool parallelDownloader::claimPiece(int workerId, std::size_t& rangeIndex, uint64_t& begin, uint64_t& end)
+{
+	std::lock_guard<std::mutex> lock(rangeMutex);
+
+	bool keepCurrent = rangeIndex < ranges.size()
+		&& (ranges[rangeIndex].owner == workerId || ranges[rangeIndex].owner == -1)
+		&& ranges[rangeIndex].next < ranges[rangeIndex].end;
+
+	if (!keepCurrent)
+	{
+		if (rangeIndex < ranges.size() && ranges[rangeIndex].owner == workerId)
+			ranges[rangeIndex].owner = -1;
+		rangeIndex = NO_RANGE;
+
+		for (std::size_t i = 0; i < ranges.size() && rangeIndex == NO_RANGE; ++i)
+		{
+			if (ranges[i].owner == -1 && ranges[i].next < ranges[i].end)
+				rangeIndex = i;
+		}
+
+		if (rangeIndex == NO_RANGE)
+		{
+			// Steal the back half of whichever stream has the most left to fetch
+			std::size_t largest = NO_RANGE;
+			uint64_t largestRemaining = 0;
+			for (std::size_t i = 0; i < ranges.size(); ++i)
+			{
+				uint64_t remaining = ranges[i].end - ranges[i].next;
+				if (remaining > largestRemaining)
+				{
+					largest = i;
+					largestRemaining = remaining;
+				}
+			}
+			if (largest == NO_RANGE || largestRemaining < 2ull * pieceSize)
+				return false;
+
+			uint64_t split = ranges[largest].next + (largestRemaining / 2 / pieceSize) * pieceSize;
+			ranges.push_back({ split, ranges[largest].end, workerId });
+			ranges[largest].end = split;
+			rangeIndex = ranges.size() - 1;
+		}
+	}
+
+	byteRange& range = ranges[rangeIndex];
+	range.owner = workerId;
+	begin = range.next;
+	end = std::min<uint64_t>(range.end, begin + pieceSize);
+	range.next = end;
+	return true;
+}
+
+void parallelDownloader::releasePiece(int workerId, std::size_t& rangeIndex, uint64_t begin, uint64_t end)
+{
+	std::lock_guard<std::mutex> lock(rangeMutex);
+	ranges.push_back({ begin, end, -1 });
+	if (rangeIndex < ranges.size() && ranges[rangeIndex].owner == workerId)
+		ranges[rangeIndex].owner = -1;
+	rangeIndex = NO_RANGE;
+}
+
+void parallelDownloader::worker(int workerId)
+{
+	std::fstream outFile(localFile, std::ios::in | std::ios::out | std::ios::binary);
+	if (!outFile)
+	{
+		setError("Failed to open file for writing.");
+		cancelled = true;
+		--activeWorkers;
+		return;
+	}
+
+	deviceLink link(serverIp, serverPort);
+	link.setRecorder(recorder);
+	std::vector<char> buffer(pieceSize);
+	std::size_t rangeIndex = static_cast<std::size_t>(workerId);
+	bool connected = false;
+	int reconnects = 0;
+	uint64_t begin = 0;
+	uint64_t end = 0;
+
+	while (!cancelled)
+	{
+		if (!connected)
+		{
+			try
+			{
+				link.connect();
+				connected = true;
+			}
+			catch (const std::exception& e)
+			{
+				setError(e.what());
+				link.close();
+				if (++reconnects > MAX_RECONNECTS) break;
+				std::this_thread::sleep_for(std::chrono::milliseconds(200));
+				continue;
+			}
+		}
+
+		if (!claimPiece(workerId, rangeIndex, begin, end))
+			break;
+
+		try
+		{
+			uint32_t length = static_cast<uint32_t>(end - begin);
+			link.requestRange(remoteFile, begin, length);
+			link.readExact(buffer.data(), length);
+		}
+		catch (const std::exception& e)
+		{
+			// Hand the piece back so a healthy stream can pick it up, then retry on a fresh connection
+			releasePiece(workerId, rangeIndex, begin, end);
+			setError(e.what());
+			link.close();
+			connected = false;
+			if (++reconnects > MAX_RECONNECTS) break;
+			continue;
+		}
+
+		outFile.seekp(static_cast<std::streamoff>(begin));
+		outFile.write(buffer.data(), static_cast<std::streamsize>(end - begin));
+		if (!outFile)
+		{
+			setError("Failed to write output file.");
+			cancelled = true;
+			break;
+		}
+		doneBytes += end - begin;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(rangeMutex);
+		if (rangeIndex < ranges.size() && ranges[rangeIndex].owner == workerId)
+			ranges[rangeIndex].owner = -1;
+	}
+	link.close();
+	--activeWorkers;
+}
+
+void parallelDownloader::run(const std::function<bool(uint64_t done, uint64_t total)>& onProgress)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	{
+		deviceLink control(serverIp, serverPort);
+		control.setRecorder(recorder);
+		control.connect();
+		totalBytes = control.fileSize(remoteFile);
+		control.close();
+	}
+
+	// Preallocate so every stream can write its ranges in place
+	{
+		std::ofstream outFile(localFile, std::ios::binary | std::ios::trunc);
+		if (!outFile)
+			throw std::runtime_error("Failed to open file for writing.");
+	}
+	std::filesystem::resize_file(localFile, totalBytes);
+	if (totalBytes == 0) return;
+
+	uint64_t share = (totalBytes + connectionCount - 1) / connectionCount;
+	share = ((share + pieceSize - 1) / pieceSize) * pieceSize;
+	for (uint64_t begin = 0; begin < totalBytes; begin += share)
+		ranges.push_back({ begin, std::min(totalBytes, begin + share), -1 });
+
+	std::vector<std::thread> workers;
+	activeWorkers = static_cast<unsigned>(ranges.size());
+	for (std::size_t i = 0; i < ranges.size(); ++i)
+		workers.emplace_back(&parallelDownloader::worker, this, static_cast<int>(i));
+
+	while (activeWorkers > 0)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		if (!cancelled && onProgress && !onProgress(doneBytes, totalBytes))
+			cancelled = true;
+	}
+	for (auto& thread : workers)
+		thread.join();
+
+	if (cancelled && lastError.empty())
+		throw std::runtime_error("Download cancelled.");
+	if (doneBytes != totalBytes)
+		throw std::runtime_error("Download incomplete: " + lastError);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	bytesPerSecond = seconds > 0 ? totalBytes / seconds : 0;
+}
@@ -0,0 +1,78 @@
+/*
+Program: ESPFileXfer
+File: paralleldownload.h
+Author: Listerine-debug
+Description: This file contains the declarations for downloading a single remote file
+over several concurrent device connections, with ranges rebalanced between streams
+and written in place into the output file.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+
+#ifndef _PARALLELDOWNLOAD_H_
+#define _PARALLELDOWNLOAD_H_
+
+#include "devicelink.h"
+#include "string"
+#include "vector"
+#include "mutex"
+#include "atomic"
+#include "functional"
+#include "cstdint"
+
+class parallelDownloader
+{
+public:
+	parallelDownloader(const std::string& ipAddress, const std::string& port,
+		const std::string& remotePath, const std::string& localPath,
+		unsigned connections, uint32_t chunkSize);
+
+	// Blocks until the file is complete, throws on failure.
+	// onProgress runs on the calling thread every 100 ms, return false to cancel.
+	void run(const std::function<bool(uint64_t done, uint64_t total)>& onProgress);
+
+	uint64_t fileSize() const { return totalBytes; }
+	double throughput() const { return bytesPerSecond; }
+	// Records every connection of the download, set before run()
+	void setRecorder(sessionRecorder* sessionRecorder) { recorder = sessionRecorder; }
+
+	static constexpr int MAX_RECONNECTS = 3;
+
+private:
+	// Unclaimed bytes [next, end) of one stream. A stream that runs out of work takes
+	// over orphaned ranges first, then splits the largest range still in progress,
+	// so a slow or stalled connection ends up with less of the file.
+	struct byteRange
+	{
+		uint64_t next;
+		uint64_t end;
+		int owner;	// worker id, -1 when orphaned
+	};
+
+	bool claimPiece(int workerId, std::size_t& rangeIndex, uint64_t& begin, uint64_t& end);
+	void releasePiece(int workerId, std::size_t& rangeIndex, uint64_t begin, uint64_t end);
+	void worker(int workerId);
+	void setError(const std::string& error);
+
+	std::string serverIp;
+	std::string serverPort;
+	std::string remoteFile;
+	std::string localFile;
+	unsigned connectionCount;
+	uint32_t pieceSize;
+	sessionRecorder* recorder = nullptr;
+
+	std::mutex rangeMutex;
+	std::vector<byteRange> ranges;
+	uint64_t totalBytes = 0;
+	std::atomic<uint64_t> doneBytes = 0;
+	std::atomic<bool> cancelled = false;
+	std::atomic<unsigned> activeWorkers = 0;
+	double bytesPerSecond = 0;
+
+	std::mutex errorMutex;
+	std::string lastError;
+};
+
+#endif// _PARALLELDOWNLOAD_H_
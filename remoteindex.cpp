@@ -0,0 +1,190 @@
+/*
+Program: ESPFileXfer
+File: remoteindex.cpp
+Author: Listerine-debug
+Description: This file contains the implementation of the cached remote directory index
+for ESPFileXfer.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+#include "remoteindex.h"
+#include "fstream"
+#include "algorithm"
+
+static const char indexMagic[8] = { 'E', 'S', 'P', 'I', 'D', 'X', '0', '2' };
+
+static void writeUint32(std::ostream& out, uint32_t value)
+{
+	char bytes[4];
+	for (int i = 0; i < 4; ++i)
+		bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+	out.write(bytes, sizeof(bytes));
+}
+
+static bool readUint32(std::istream& in, uint32_t& value)
+{
+	unsigned char bytes[4];
+	if (!in.read(reinterpret_cast<char*>(bytes), sizeof(bytes))) return false;
+	value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+	return true;
+}
+
+static void writeString(std::ostream& out, const std::string& text)
+{
+	writeUint32(out, static_cast<uint32_t>(text.size()));
+	out.write(text.data(), text.size());
+}
+
+static bool readString(std::istream& in, std::string& text)
+{
+	uint32_t len = 0;
+	if (!readUint32(in, len) || len > 0xFFFF) return false;
+	text.resize(len);
+	return len == 0 || static_cast<bool>(in.read(&text[0], len));
+}
+
+static uint32_t pageCount(uint32_t total)
+{
+	return (total + remoteIndex::LISTING_PAGE_SIZE - 1) / remoteIndex::LISTING_PAGE_SIZE;
+}
+
+bool remoteIndex::load(const std::string& path)
+{
+	std::ifstream indexFile(path, std::ios::binary);
+	if (!indexFile) return false;
+
+	char magic[8];
+	if (!indexFile.read(magic, sizeof(magic)) || !std::equal(indexMagic, indexMagic + 8, magic)) return false;
+
+	uint32_t directoryCount = 0;
+	if (!readUint32(indexFile, directoryCount)) return false;
+
+	std::map<std::string, remoteListing> loaded;
+	for (uint32_t d = 0; d < directoryCount; ++d)
+	{
+		std::string directory;
+		remoteListing listing;
+		if (!readString(indexFile, directory) || !readUint32(indexFile, listing.total))
+			return false;
+
+		listing.entries.resize(listing.total);
+		listing.pageValid.assign(pageCount(listing.total), false);
+		for (auto& entry : listing.entries)
+		{
+			char flags = 0;
+			if (!indexFile.get(flags) || !readString(indexFile, entry.name) ||
+				!readUint32(indexFile, entry.size) || !readUint32(indexFile, entry.modified))
+				return false;
+			entry.isDirectory = (flags & 0x01) != 0;
+		}
+
+		// Only pages that were completely fetched are trusted after a reload
+		for (uint32_t page = 0; page < listing.pageValid.size(); ++page)
+		{
+			bool complete = true;
+			for (uint32_t i = page * LISTING_PAGE_SIZE; i < listing.total && i < (page + 1) * LISTING_PAGE_SIZE; ++i)
+				complete = complete && !listing.entries[i].name.empty();
+			listing.pageValid[page] = complete;
+		}
+		loaded[directory] = std::move(listing);
+	}
+
+	listings = std::move(loaded);
+	return true;
+}
+
+bool remoteIndex::save(const std::string& path) const
+{
+	std::ofstream indexFile(path, std::ios::binary | std::ios::trunc);
+	if (!indexFile) return false;
+
+	indexFile.write(indexMagic, sizeof(indexMagic));
+	writeUint32(indexFile, static_cast<uint32_t>(listings.size()));
+	for (const auto& item : listings)
+	{
+		const remoteListing& listing = item.second;
+		writeString(indexFile, item.first);
+		writeUint32(indexFile, listing.total);
+		for (uint32_t i = 0; i < listing.total; ++i)
+		{
+			// Stale pages are saved without names so they are refetched next time
+			const remoteEntry& entry = listing.entries[i];
+			bool valid = listing.pageValid[i / LISTING_PAGE_SIZE];
+			indexFile.put(entry.isDirectory ? 0x01 : 0x00);
+			writeString(indexFile, valid ? entry.name : std::string());
+			writeUint32(indexFile, entry.size);
+			writeUint32(indexFile, entry.modified);
+		}
+	}
+	return static_cast<bool>(indexFile);
+}
+
+remoteListing* remoteIndex::find(const std::string& directory)
+{
+	auto it = listings.find(directory);
+	return it == listings.end() ? nullptr : &it->second;
+}
+
+uint32_t remoteIndex::pageChecksum(const remoteListing& listing, uint32_t page)
+{
+	uint32_t hash = 2166136261u;
+	auto mix = [&hash](uint8_t byte)
+		{
+			hash ^= byte;
+			hash *= 16777619u;
+		};
+
+	for (uint32_t i = page * LISTING_PAGE_SIZE; i < listing.total && i < (page + 1) * LISTING_PAGE_SIZE; ++i)
+	{
+		const remoteEntry& entry = listing.entries[i];
+		for (char c : entry.name)
+			mix(static_cast<uint8_t>(c));
+		mix(entry.isDirectory ? 1 : 0);
+		for (int b = 0; b < 4; ++b)
+			mix(static_cast<uint8_t>(entry.size >> (8 * b)));
+		for (int b = 0; b < 4; ++b)
+			mix(static_cast<uint8_t>(entry.modified >> (8 * b)));
+	}
+	return hash;
+}
+
+uint32_t remoteIndex::applyChecksums(const std::string& directory, uint32_t total, const std::vector<uint32_t>& checksums)
+{
+	remoteListing& listing = listings[directory];
+
+	// A page is kept when it was complete and hashes to what the device reports, so an
+	// append only refetches the last page and a rename only refetches the page it is on
+	std::vector<bool> valid(pageCount(total), false);
+	uint32_t stale = 0;
+	for (uint32_t page = 0; page < valid.size(); ++page)
+	{
+		valid[page] = page < checksums.size() && page < listing.pageValid.size() && listing.pageValid[page]
+			&& pageChecksum(listing, page) == checksums[page];
+		if (!valid[page]) ++stale;
+	}
+
+	listing.total = total;
+	listing.entries.resize(total);
+	listing.pageValid = std::move(valid);
+	return stale;
+}
+
+void remoteIndex::applyPage(const std::string& directory, uint32_t page, std::vector<remoteEntry>& entries)
+{
+	remoteListing* listing = find(directory);
+	if (!listing || page >= listing->pageValid.size()) return;
+
+	uint32_t first = page * LISTING_PAGE_SIZE;
+	for (uint32_t i = 0; i < entries.size() && first + i < listing->total; ++i)
+		listing->entries[first + i] = std::move(entries[i]);
+	listing->pageValid[page] = true;
+}
+
+void remoteIndex::invalidate(const std::string& directory)
+{
+	remoteListing* listing = find(directory);
+	if (!listing) return;
+
+	listing->pageValid.assign(listing->pageValid.size(), false);
+}
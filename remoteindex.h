@@ -0,0 +1,53 @@
+/*
+Program: ESPFileXfer
+File: remoteindex.h
+Author: Listerine-debug
+Description: This file contains the declarations for the locally cached index of a
+device's SD card directories, filled a page at a time by the remote browser and
+revalidated page by page against checksums reported by the device.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+
+#ifndef _REMOTEINDEX_H_
+#define _REMOTEINDEX_H_
+
+#include "devicelink.h"
+#include "string"
+#include "vector"
+#include "map"
+#include "cstdint"
+
+struct remoteListing
+{
+	uint32_t total = 0;
+	std::vector<remoteEntry> entries;	// sized to total, unfetched entries have no name
+	std::vector<bool> pageValid;
+};
+
+class remoteIndex
+{
+public:
+	bool load(const std::string& path);
+	bool save(const std::string& path) const;
+
+	remoteListing* find(const std::string& directory);
+
+	// Compares the device's per-page checksums with the cached pages and returns how many
+	// pages changed. Only those are marked stale, their old entries stay on screen until
+	// the page is refetched.
+	uint32_t applyChecksums(const std::string& directory, uint32_t total, const std::vector<uint32_t>& checksums);
+	void applyPage(const std::string& directory, uint32_t page, std::vector<remoteEntry>& entries);
+	void invalidate(const std::string& directory);
+
+	// Same FNV-1a hash the firmware computes, see deviceLink::pageChecksums
+	static uint32_t pageChecksum(const remoteListing& listing, uint32_t page);
+
+	static constexpr uint32_t LISTING_PAGE_SIZE = 64;
+
+private:
+	std::map<std::string, remoteListing> listings;
+};
+
+#endif// _REMOTEINDEX_H_
@@ -0,0 +1,258 @@
+/*
+Program: ESPFileXfer
+File: replaytest.cpp
+Author: Listerine-debug
+Description: This file contains the implementation of the headless capture replay test
+for ESPFileXfer.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+#include "replaytest.h"
+#include "deviceprotocol.h"
+#include "paralleldownload.h"
+#include "future"
+#include "thread"
+#include "fstream"
+#include "filesystem"
+#include "iterator"
+#include "algorithm"
+#include "sstream"
+#include "iomanip"
+
+using asio::ip::tcp;
+
+std::string replayReport::summary() const
+{
+	std::ostringstream text;
+	text << (passed ? "PASSED" : "FAILED") << "\n";
+	for (const std::string& check : checks)
+		text << "  " << check << "\n";
+	if (timing.error.empty())
+		text << std::fixed << std::setprecision(3) << "Replay " << timing.replayNs / 1e6
+			<< " ms, recorded " << timing.recordedNs / 1e6 << " ms\n";
+	else
+		text << "Replay server: " << timing.error << "\n";
+	return text.str();
+}
+
+// One report line for a transfer, clears matches when the bytes differ
+static std::string compareTransfer(const std::string& label, const std::string& actual, const std::string& expected, bool& matches)
+{
+	if (actual == expected)
+		return label + ": " + std::to_string(actual.size()) + " bytes match the capture";
+
+	std::size_t differs = 0;
+	while (differs < actual.size() && differs < expected.size() && actual[differs] == expected[differs])
+		++differs;
+	matches = false;
+	return label + ": got " + std::to_string(actual.size()) + " bytes, capture has "
+		+ std::to_string(expected.size()) + ", first difference at byte " + std::to_string(differs);
+}
+
+// Runs a recorded Parallel Extract through parallelDownloader with the recorded connection
+// count and chunk size. The replay server answers its connections from the recorded device.
+static std::string replayDownload(const recordedDevice& device, const recordedDevice::download& recorded,
+	int number, unsigned short port, bool& matches)
+{
+	std::string label = "Parallel Extract " + std::to_string(number) + " of " + recorded.path;
+	std::string expected;
+	if (!device.fileContent(recorded.path, expected))
+		return label + ": the capture does not hold the whole file, skipped";
+
+	std::filesystem::path localPath = std::filesystem::temp_directory_path() / ("espfilexfer_replay_" + std::to_string(number) + ".bin");
+	std::string actual;
+	std::string error;
+	try
+	{
+		parallelDownloader downloader("127.0.0.1", std::to_string(port), recorded.path, localPath.string(),
+			recorded.connections, std::max<uint32_t>(recorded.chunkSize, 1024));
+		downloader.run(nullptr);
+
+		std::ifstream downloaded(localPath, std::ios::binary);
+		actual.assign(std::istreambuf_iterator<char>(downloaded), std::istreambuf_iterator<char>());
+	}
+	catch (const std::exception& e)
+	{
+		error = e.what();
+	}
+	std::error_code ignored;
+	std::filesystem::remove(localPath, ignored);
+
+	if (!error.empty())
+	{
+		matches = false;
+		return label + ": " + error;
+	}
+	return compareTransfer(label + " over " + std::to_string(recorded.connections) + " connections", actual, expected, matches);
+}
+
+replayReport sessionReplayTest::run(const std::string& capturePath, double speed, std::chrono::milliseconds readTimeout)
+{
+	replayReport report;
+
+	std::vector<captureRecord> records;
+	captureTransport transport = captureTransport::UNKNOWN;
+	std::string error;
+	if (!sessionReader::load(capturePath, records, transport, error))
+	{
+		report.checks.push_back(error);
+		return report;
+	}
+
+	// Stream 0 is the window, driven below. Parallel Extract streams are only used to find out
+	// which downloads to repeat, the host picks its own ranges when it repeats them.
+	recordedDevice device(records);
+	std::vector<captureRecord> window;
+	std::copy_if(records.begin(), records.end(), std::back_inserter(window),
+		[](const captureRecord& record) { return record.stream == 0; });
+	records.clear();
+
+	// The callback may outlive this call if the server never sees a connection
+	auto finished = std::make_shared<std::promise<replayResult>>();
+	std::future<replayResult> finishedFuture = finished->get_future();
+	unsigned short port = 0;
+	try
+	{
+		auto replayServer = std::make_shared<sessionReplayServer>(capturePath, speed);
+		port = replayServer->start([finished](const replayResult& result) { finished->set_value(result); });
+	}
+	catch (const std::exception& e)
+	{
+		report.checks.push_back(e.what());
+		return report;
+	}
+
+	bool transfersMatch = true;
+	try
+	{
+		asio::io_context ioContext;
+		tcp::socket socket(ioContext);
+		deviceProtocol::timedConnect(ioContext, socket, "127.0.0.1", std::to_string(port), readTimeout);
+
+		// Device bytes the capture says had arrived by now versus bytes actually read. Before
+		// each host write the difference is read off the socket, which is what a person
+		// watching the chat log would have waited for before typing. They then take as long
+		// to type as they did in the recording, so the replay and the recorded duration both
+		// hold the same think time and only host processing can tell them apart.
+		uint64_t recordedRead = 0;
+		uint64_t consumed = 0;
+		uint64_t lastReadNs = 0;
+		auto anchorTime = std::chrono::steady_clock::now();
+		uint64_t anchorNs = 0;
+		std::vector<char> pending;
+		auto catchUp = [&]()
+			{
+				if (recordedRead <= consumed) return;
+				std::chrono::milliseconds timeout = readTimeout;
+				if (speed > 0 && lastReadNs > anchorNs)
+					timeout += std::chrono::milliseconds(static_cast<uint64_t>((lastReadNs - anchorNs) / speed / 1e6));
+				pending.resize(static_cast<std::size_t>(recordedRead - consumed));
+				deviceProtocol::timedRead(ioContext, socket, pending.data(), pending.size(), timeout);
+				consumed = recordedRead;
+				anchorTime = std::chrono::steady_clock::now();
+				anchorNs = lastReadNs;
+			};
+		auto typeAt = [&](uint64_t timestampNs)
+			{
+				if (speed > 0 && timestampNs > anchorNs)
+					std::this_thread::sleep_until(anchorTime + std::chrono::nanoseconds(static_cast<uint64_t>((timestampNs - anchorNs) / speed)));
+				anchorTime = std::chrono::steady_clock::now();
+				anchorNs = timestampNs;
+			};
+
+		const std::string handshakeCmd(1, static_cast<char>(deviceProtocol::HANDSHAKE));
+		const std::string extractCmd(1, static_cast<char>(deviceProtocol::EXTRACT));
+		std::size_t skipWrite = window.size();
+		sessionRecorder notRecording;
+		int extractCount = 0;
+
+		// The window sat idle during a Parallel Extract, so each one runs where it started. The
+		// capture does not hold the moment the recorded download returned, so what follows stays
+		// paced from its start and a download slower than recorded delays everything after it.
+		const std::vector<recordedDevice::download>& downloads = device.downloads();
+		std::size_t nextDownload = 0;
+		auto runDownloads = [&](uint64_t beforeNs)
+			{
+				for (; nextDownload < downloads.size() && downloads[nextDownload].startNs < beforeNs; ++nextDownload)
+				{
+					catchUp();
+					typeAt(downloads[nextDownload].startNs);
+					report.checks.push_back(replayDownload(device, downloads[nextDownload], static_cast<int>(nextDownload) + 1, port, transfersMatch));
+				}
+			};
+
+		for (std::size_t i = 0; i < window.size(); ++i)
+		{
+			const captureRecord& record = window[i];
+			if (record.direction == captureDirection::READ)
+			{
+				recordedRead += record.data.size();
+				lastReadNs = record.timestampNs;
+				continue;
+			}
+			if (i == skipWrite)
+				continue;
+
+			runDownloads(record.timestampNs);
+			catchUp();
+			typeAt(record.timestampNs);
+
+			// HANDSHAKE followed by EXTRACT is the Extract button. Everything else was typed.
+			std::size_t nextWrite = i + 1;
+			while (nextWrite < window.size() && window[nextWrite].direction != captureDirection::WRITE)
+				++nextWrite;
+			bool isExtract = record.data == handshakeCmd && nextWrite < window.size() && window[nextWrite].data == extractCmd;
+
+			// The recorded file is what came after EXTRACT up to the first SUCCESS. A capture
+			// stopped before SUCCESS is replayed as plain writes, extractFile would wait forever.
+			std::string expected;
+			bool complete = false;
+			uint64_t successNs = 0;
+			for (std::size_t j = nextWrite + 1; isExtract && j < window.size() && window[j].direction == captureDirection::READ; ++j)
+			{
+				std::size_t success = window[j].data.find(static_cast<char>(deviceProtocol::SUCCESS));
+				expected.append(window[j].data, 0, success);
+				complete = success != std::string::npos;
+				successNs = window[j].timestampNs;
+				if (complete) break;
+			}
+			if (!complete)
+			{
+				asio::write(socket, asio::buffer(record.data));
+				continue;
+			}
+
+			std::string extracted;
+			uint64_t readAfterExtract = deviceProtocol::extractFile(socket, notRecording,
+				[&extracted](const char* data, std::size_t len) { extracted.append(data, len); });
+			consumed += 1 + readAfterExtract;
+			skipWrite = nextWrite;
+			anchorTime = std::chrono::steady_clock::now();
+			anchorNs = successNs;
+			++extractCount;
+			report.checks.push_back(compareTransfer("Extract " + std::to_string(extractCount), extracted, expected, transfersMatch));
+		}
+
+		// Let the last recorded output arrive, then hang up so the server stops the clock
+		runDownloads(UINT64_MAX);
+		catchUp();
+		asio::error_code ignored;
+		socket.shutdown(tcp::socket::shutdown_both, ignored);
+		socket.close(ignored);
+	}
+	catch (const std::exception& e)
+	{
+		report.checks.push_back(std::string("Host side failed: ") + e.what());
+		transfersMatch = false;
+	}
+
+	if (finishedFuture.wait_for(readTimeout) != std::future_status::ready)
+	{
+		report.timing.error = "Replay server did not finish";
+		return report;
+	}
+	report.timing = finishedFuture.get();
+	report.passed = transfersMatch && report.timing.error.empty();
+	return report;
+}
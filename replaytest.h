@@ -0,0 +1,45 @@
+/*
+Program: ESPFileXfer
+File: replaytest.h
+Author: Listerine-debug
+Description: This file contains the declarations for running a WiFi session capture
+against the host transfer code without a window, checking both the bytes the host
+sends and the files it extracts.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+
+#ifndef _REPLAYTEST_H_
+#define _REPLAYTEST_H_
+
+#include "capture.h"
+#include "string"
+#include "vector"
+#include "chrono"
+#include "cstdint"
+
+struct replayReport
+{
+	bool passed = false;
+	std::vector<std::string> checks;	// one line per extracted file or failure, in order
+	replayResult timing;				// from the replay server
+
+	std::string summary() const;
+};
+
+// Stands in for the person at the keyboard of a wifiSerialFrame: text they typed is sent as
+// soon as the device output recorded before it has arrived, each Extract runs through
+// deviceProtocol::extractFile exactly as the window does and each Parallel Extract through
+// parallelDownloader. Every transferred file is compared with the bytes in the capture, and
+// the replay server rejects any window write that differs.
+class sessionReplayTest
+{
+public:
+	// speed as for sessionReplayServer. readTimeout bounds each wait for recorded device output
+	// on top of the recorded gap, so a replay that stalls fails instead of hanging.
+	static replayReport run(const std::string& capturePath, double speed,
+		std::chrono::milliseconds readTimeout = std::chrono::milliseconds(10000));
+};
+
+#endif// _REPLAYTEST_H_
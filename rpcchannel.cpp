@@ -0,0 +1,491 @@
+/*
+Program: ESPFileXfer
+File: rpcchannel.cpp
+Author: Listerine-debug
+Description: This file contains the implementation of the pipelined command RPC channel
+for ESPFileXfer.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+#include "rpcchannel.h"
+#include "fstream"
+#include "stdexcept"
+#include "algorithm"
+
+using asio::ip::tcp;
+
+// Latency is tracked per command name, arguments are ignored
+static std::string commandName(const std::string& command)
+{
+	std::size_t begin = command.find_first_not_of(" \t");
+	if (begin == std::string::npos) return "";
+	std::size_t end = command.find_first_of(" \t", begin);
+	return command.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+}
+
+void rttHistogram::add(uint64_t micros)
+{
+	int bucket = 0;
+	while (bucket < BUCKETS - 1 && micros >= bucketUpperMicros(bucket))
+		++bucket;
+
+	++buckets[bucket];
+	++count;
+	sumMicros += micros;
+	minMicros = std::min(minMicros, micros);
+	maxMicros = std::max(maxMicros, micros);
+}
+
+uint64_t rttHistogram::percentile(double fraction) const
+{
+	if (count == 0) return 0;
+
+	uint64_t target = static_cast<uint64_t>(fraction * count + 0.5);
+	target = std::max<uint64_t>(target, 1);
+	uint64_t seen = 0;
+	for (int bucket = 0; bucket < BUCKETS; ++bucket)
+	{
+		seen += buckets[bucket];
+		if (seen >= target)
+			return std::max(minMicros, std::min(maxMicros, bucketUpperMicros(bucket)));
+	}
+	return maxMicros;
+}
+
+struct rpcChannel::scriptState
+{
+	std::vector<std::string> commands;
+	uint64_t total = 0;
+	uint64_t issued = 0;
+	uint64_t completed = 0;
+	uint64_t failures = 0;
+	unsigned window = 1;
+	std::chrono::steady_clock::time_point start;
+	std::function<void(const scriptSummary& summary)> onDone;
+};
+
+rpcChannel::rpcChannel(const std::string& ipAddress, const std::string& port)
+	: serverIp(ipAddress), serverPort(port)
+{
+}
+
+rpcChannel::~rpcChannel()
+{
+	close();
+}
+
+void rpcChannel::connect(std::chrono::milliseconds timeout)
+{
+	// Also how a dead channel reconnects, the old io thread and everything it left queued go first
+	close();
+
+	try
+	{
+		// Commands are a handful of bytes, timedConnect turns Nagle off so none waits for the previous ACK
+		timedConnect(ioContext, socket, serverIp, serverPort, timeout);
+
+		char handshakeCmd = static_cast<char>(HANDSHAKE);
+		asio::write(socket, asio::buffer(&handshakeCmd, 1));
+
+		char response = 0;
+		timedRead(ioContext, socket, &response, 1, timeout);
+		if (response != static_cast<char>(HANDSHAKE))
+			throw std::runtime_error("Handshake failed");
+	}
+	catch (const std::exception& e)
+	{
+		asio::error_code ignored;
+		socket.close(ignored);
+		std::lock_guard<std::mutex> lock(errorMutex);
+		deadError = e.what();
+		throw;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(errorMutex);
+		deadError.clear();
+	}
+	dead = false;
+
+	ioContext.restart();
+	workGuard = std::make_unique<asio::executor_work_guard<asio::io_context::executor_type>>(ioContext.get_executor());
+	startRead();
+	sweepTimeouts();
+	ioThread = std::thread([this]() { ioContext.run(); });
+}
+
+void rpcChannel::close()
+{
+	// Outstanding callbacks are dropped, nothing is delivered after close returns
+	if (!dead)
+	{
+		std::lock_guard<std::mutex> lock(errorMutex);
+		deadError = "Channel closed";
+	}
+	dead = true;
+
+	if (ioThread.joinable())
+	{
+		workGuard.reset();
+		ioContext.stop();
+		ioThread.join();
+	}
+
+	asio::error_code ignored;
+	sweepTimer.cancel();
+	socket.shutdown(tcp::socket::shutdown_both, ignored);
+	socket.close(ignored);
+	pending.clear();
+	writeQueue.clear();
+	writing.clear();
+	writeInProgress = false;
+	flushPosted = false;
+
+	// Run what the stopped io thread left queued, aborted reads and writes and posted calls,
+	// with their callbacks dropped so none of it touches the next connection
+	closing = true;
+	ioContext.restart();
+	ioContext.run();
+	closing = false;
+	inFlightCount = 0;
+}
+
+uint32_t rpcChannel::call(const std::string& command, replyHandler onReply)
+{
+	uint32_t id = nextId++;
+	auto sent = std::chrono::steady_clock::now();
+
+	if (command.size() > MAX_COMMAND)
+	{
+		rpcResult result;
+		result.id = id;
+		result.reply = "Command too long";
+		if (onReply) onReply(result);
+		return id;
+	}
+	if (dead)
+	{
+		failCall(id, command, lastError(), onReply);
+		return id;
+	}
+
+	std::string frame(7, '\0');
+	frame[0] = static_cast<char>(RPC);
+	putLittleEndian(&frame[1], id, 4);
+	putLittleEndian(&frame[5], command.size(), 2);
+	frame += command;
+
+	++inFlightCount;
+	asio::post(ioContext, [this, id, sent, command, frame = std::move(frame), onReply = std::move(onReply)]() mutable
+		{
+			if (closing)
+				return;
+
+			// The connection may have failed after call() checked
+			if (dead)
+			{
+				--inFlightCount;
+				failCall(id, command, lastError(), onReply);
+				return;
+			}
+
+			pending[id] = { command, sent, std::move(onReply) };
+			writeQueue.push_back(std::move(frame));
+
+			// Flush after whatever else is already queued has run, so a burst of calls
+			// leaves as one write instead of one segment per request
+			if (!writeInProgress && !flushPosted)
+			{
+				flushPosted = true;
+				asio::post(ioContext, [this]() { flushPosted = false; startWrite(); });
+			}
+		});
+	return id;
+}
+
+void rpcChannel::startWrite()
+{
+	if (writeInProgress || writeQueue.empty())
+		return;
+
+	writing.swap(writeQueue);
+	writeQueue.clear();
+	writeInProgress = true;
+
+	std::vector<asio::const_buffer> buffers;
+	buffers.reserve(writing.size());
+	for (const auto& frame : writing)
+		buffers.push_back(asio::buffer(frame));
+
+	asio::async_write(socket, buffers, [this](const asio::error_code& error, std::size_t)
+		{
+			writeInProgress = false;
+			writing.clear();
+			if (error)
+			{
+				fail("Write error: " + error.message());
+				return;
+			}
+			startWrite();
+		});
+}
+
+void rpcChannel::startRead()
+{
+	asio::async_read(socket, asio::buffer(replyHeader, sizeof(replyHeader)),
+		[this](const asio::error_code& error, std::size_t)
+		{
+			if (error)
+			{
+				fail("Read error: " + error.message());
+				return;
+			}
+			if (static_cast<uint8_t>(replyHeader[0]) != RPC)
+			{
+				fail("Unexpected reply from device");
+				return;
+			}
+
+			uint32_t id = getLittleEndian(replyHeader + 1, 4);
+			bool ok = static_cast<uint8_t>(replyHeader[5]) == SUCCESS;
+			uint16_t length = static_cast<uint16_t>(getLittleEndian(replyHeader + 6, 2));
+			readPayload(id, ok, length);
+		});
+}
+
+void rpcChannel::readPayload(uint32_t id, bool ok, uint16_t length)
+{
+	replyPayload.resize(length);
+	if (length == 0)
+	{
+		complete(id, ok, replyPayload);
+		startRead();
+		return;
+	}
+
+	asio::async_read(socket, asio::buffer(&replyPayload[0], length),
+		[this, id, ok](const asio::error_code& error, std::size_t)
+		{
+			if (error)
+			{
+				fail("Read error: " + error.message());
+				return;
+			}
+			complete(id, ok, replyPayload);
+			startRead();
+		});
+}
+
+void rpcChannel::complete(uint32_t id, bool ok, const std::string& reply)
+{
+	// Replies to requests that already timed out are dropped
+	auto it = pending.find(id);
+	if (it == pending.end())
+		return;
+
+	pendingRequest request = std::move(it->second);
+	pending.erase(it);
+	--inFlightCount;
+
+	rpcResult result;
+	result.id = id;
+	result.ok = ok;
+	result.reply = reply;
+	result.rtt = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - request.sent);
+
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		rttHistogram& histogram = stats[commandName(request.command)];
+		histogram.add(static_cast<uint64_t>(result.rtt.count()));
+		if (!ok) ++histogram.failures;
+	}
+
+	if (request.onReply)
+		request.onReply(result);
+}
+
+void rpcChannel::fail(const std::string& error)
+{
+	if (closing)
+		return;
+
+	// The first error wins, the read and the write side usually both see the connection drop
+	if (!dead)
+	{
+		{
+			std::lock_guard<std::mutex> lock(errorMutex);
+			deadError = error;
+		}
+		dead = true;
+	}
+
+	asio::error_code ignored;
+	socket.close(ignored);
+	failAll(lastError());
+}
+
+std::string rpcChannel::lastError() const
+{
+	std::lock_guard<std::mutex> lock(errorMutex);
+	return deadError;
+}
+
+void rpcChannel::failCall(uint32_t id, const std::string& command, const std::string& error, const replyHandler& onReply)
+{
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		++stats[commandName(command)].failures;
+	}
+
+	rpcResult result;
+	result.id = id;
+	result.reply = error;
+	if (onReply)
+		onReply(result);
+}
+
+void rpcChannel::failAll(const std::string& error)
+{
+	std::map<uint32_t, pendingRequest> failed;
+	failed.swap(pending);
+	inFlightCount -= failed.size();
+
+	for (auto& item : failed)
+		failCall(item.first, item.second.command, error, item.second.onReply);
+}
+
+void rpcChannel::sweepTimeouts()
+{
+	auto now = std::chrono::steady_clock::now();
+	std::vector<uint32_t> expired;
+	for (const auto& item : pending)
+	{
+		if (now - item.second.sent > requestTimeout)
+			expired.push_back(item.first);
+	}
+
+	for (uint32_t id : expired)
+	{
+		pendingRequest request = std::move(pending[id]);
+		pending.erase(id);
+		--inFlightCount;
+
+		{
+			std::lock_guard<std::mutex> lock(statsMutex);
+			++stats[commandName(request.command)].failures;
+		}
+
+		rpcResult result;
+		result.id = id;
+		result.reply = "Timed out";
+		if (request.onReply)
+			request.onReply(result);
+	}
+
+	sweepTimer.expires_after(std::chrono::milliseconds(250));
+	sweepTimer.async_wait([this](const asio::error_code& error)
+		{
+			if (!error)
+				sweepTimeouts();
+		});
+}
+
+void rpcChannel::runScript(const std::vector<std::string>& commands, uint64_t repeat, unsigned window,
+	std::function<void(const scriptSummary& summary)> onDone)
+{
+	auto state = std::make_shared<scriptState>();
+	state->commands = commands;
+	state->total = commands.size() * repeat;
+	state->window = std::min(std::max(window, 1u), MAX_WINDOW);
+	state->start = std::chrono::steady_clock::now();
+	state->onDone = std::move(onDone);
+	scriptCancelled = false;
+
+	if (dead)
+	{
+		scriptSummary summary;
+		summary.error = lastError();
+		if (state->onDone) state->onDone(summary);
+		return;
+	}
+	asio::post(ioContext, [this, state]() { issueScript(state); });
+}
+
+void rpcChannel::issueScript(const std::shared_ptr<scriptState>& state)
+{
+	// A lost connection ends the script, the requests still in flight fail with it
+	bool stopping = scriptCancelled || dead;
+	while (!stopping && state->issued < state->total && state->issued - state->completed < state->window)
+	{
+		const std::string& command = state->commands[state->issued % state->commands.size()];
+		++state->issued;
+
+		// Each reply frees a slot in the window for the next command
+		call(command, [this, state](const rpcResult& result)
+			{
+				++state->completed;
+				if (!result.ok) ++state->failures;
+				issueScript(state);
+			});
+	}
+
+	if (state->completed == state->issued && (stopping || state->issued == state->total) && state->onDone)
+	{
+		scriptSummary summary;
+		summary.completed = state->completed;
+		summary.failures = state->failures;
+		summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - state->start).count();
+		summary.cancelled = scriptCancelled && state->issued < state->total;
+		if (dead)
+			summary.error = lastError();
+
+		auto onDone = std::move(state->onDone);
+		state->onDone = nullptr;
+		onDone(summary);
+	}
+}
+
+std::map<std::string, rttHistogram> rpcChannel::histograms() const
+{
+	std::lock_guard<std::mutex> lock(statsMutex);
+	return stats;
+}
+
+void rpcChannel::resetHistograms()
+{
+	std::lock_guard<std::mutex> lock(statsMutex);
+	stats.clear();
+}
+
+bool rpcChannel::exportCsv(const std::string& path) const
+{
+	std::ofstream csvFile(path, std::ios::trunc);
+	if (!csvFile) return false;
+
+	csvFile << "command,count,failures,min_us,mean_us,p50_us,p90_us,p99_us,max_us";
+	for (int bucket = 0; bucket < rttHistogram::BUCKETS; ++bucket)
+		csvFile << ",lt_" << rttHistogram::bucketUpperMicros(bucket) << "us";
+	csvFile << "\n";
+
+	for (const auto& item : histograms())
+	{
+		const rttHistogram& histogram = item.second;
+		std::string name = item.first;
+		if (name.find_first_of(",\"") != std::string::npos)
+		{
+			for (std::size_t i = name.find('"'); i != std::string::npos; i = name.find('"', i + 2))
+				name.insert(i, 1, '"');
+			name = "\"" + name + "\"";
+		}
+
+		csvFile << name << "," << histogram.count << "," << histogram.failures << ","
+			<< (histogram.count ? histogram.minMicros : 0) << "," << static_cast<uint64_t>(histogram.meanMicros()) << ","
+			<< histogram.percentile(0.50) << "," << histogram.percentile(0.90) << ","
+			<< histogram.percentile(0.99) << "," << histogram.maxMicros;
+		for (int bucket = 0; bucket < rttHistogram::BUCKETS; ++bucket)
+			csvFile << "," << histogram.buckets[bucket];
+		csvFile << "\n";
+	}
+	return static_cast<bool>(csvFile);
+}
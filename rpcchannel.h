@@ -0,0 +1,154 @@
+/*
+Program: ESPFileXfer
+File: rpcchannel.h
+Author: Listerine-debug
+Description: This file contains the declarations for the pipelined command RPC channel,
+which matches device replies to requests by ID, keeps many requests in flight on one
+connection and records per-command round-trip latency histograms.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+
+#ifndef _RPCCHANNEL_H_
+#define _RPCCHANNEL_H_
+
+#include "deviceprotocol.h"
+#include "string"
+#include "vector"
+#include "map"
+#include "mutex"
+#include "atomic"
+#include "thread"
+#include "chrono"
+#include "functional"
+#include "memory"
+#include "cstdint"
+
+// Round-trip times in microseconds, bucket i counts samples in [2^i, 2^(i+1)),
+// bucket 0 also takes anything under 1 us
+struct rttHistogram
+{
+	static constexpr int BUCKETS = 32;
+
+	uint64_t buckets[BUCKETS] = {};
+	uint64_t count = 0;
+	uint64_t failures = 0;
+	uint64_t sumMicros = 0;
+	uint64_t minMicros = UINT64_MAX;
+	uint64_t maxMicros = 0;
+
+	void add(uint64_t micros);
+	// Upper edge of the bucket holding the requested fraction, clamped to the observed range
+	uint64_t percentile(double fraction) const;
+	double meanMicros() const { return count ? static_cast<double>(sumMicros) / count : 0.0; }
+	static uint64_t bucketUpperMicros(int bucket) { return 2ull << bucket; }
+};
+
+struct rpcResult
+{
+	uint32_t id = 0;
+	bool ok = false;
+	std::string reply;		// device reply, or the error text when the request did not complete
+	std::chrono::microseconds rtt{ 0 };
+};
+
+struct scriptSummary
+{
+	uint64_t completed = 0;
+	uint64_t failures = 0;
+	double seconds = 0;
+	bool cancelled = false;
+	std::string error;		// set when the connection failed before the script finished
+};
+
+// Frames (little endian), sent on a connection that already did the handshake:
+//   request : uint8 RPC, uint32 id, uint16 length, command text
+//   reply   : uint8 RPC, uint32 id, uint8 SUCCESS / FAILURE, uint16 length, reply text
+// Replies may come back in any order. Callbacks run on the channel's io thread, except
+// that on a dead channel call() and runScript() fail straight away on the caller's thread.
+class rpcChannel : public deviceProtocol
+{
+public:
+	using replyHandler = std::function<void(const rpcResult& result)>;
+
+	rpcChannel(const std::string& ipAddress, const std::string& port);
+	~rpcChannel();
+
+	// Connects, performs the handshake and starts the io thread, throws on failure.
+	// Calling it again on a dead channel reconnects.
+	void connect(std::chrono::milliseconds timeout = std::chrono::milliseconds(3000));
+	void close();
+
+	// Thread safe. Requests queued before the next write starts go out in one write.
+	// Once the connection has failed every call fails straight away with the error.
+	uint32_t call(const std::string& command, replyHandler onReply);
+
+	// Issues the commands repeat times over, keeping at most window requests in flight
+	void runScript(const std::vector<std::string>& commands, uint64_t repeat, unsigned window,
+		std::function<void(const scriptSummary& summary)> onDone);
+	void cancelScript() { scriptCancelled = true; }
+
+	std::map<std::string, rttHistogram> histograms() const;
+	void resetHistograms();
+	bool exportCsv(const std::string& path) const;
+	std::size_t inFlight() const { return inFlightCount; }
+	bool connected() const { return !dead; }
+	std::string lastError() const;
+
+	std::chrono::milliseconds requestTimeout = std::chrono::milliseconds(5000);
+
+	static constexpr unsigned MAX_WINDOW = 256;
+	static constexpr std::size_t MAX_COMMAND = 0xFFFF;
+
+private:
+	struct pendingRequest
+	{
+		std::string command;
+		std::chrono::steady_clock::time_point sent;
+		replyHandler onReply;
+	};
+
+	struct scriptState;
+
+	void startWrite();
+	void startRead();
+	void readPayload(uint32_t id, bool ok, uint16_t length);
+	void complete(uint32_t id, bool ok, const std::string& reply);
+	void fail(const std::string& error);
+	void failAll(const std::string& error);
+	void failCall(uint32_t id, const std::string& command, const std::string& error, const replyHandler& onReply);
+	void sweepTimeouts();
+	void issueScript(const std::shared_ptr<scriptState>& state);
+
+	std::string serverIp;
+	std::string serverPort;
+	asio::io_context ioContext;
+	asio::ip::tcp::socket socket{ ioContext };
+	asio::steady_timer sweepTimer{ ioContext };
+	std::unique_ptr<asio::executor_work_guard<asio::io_context::executor_type>> workGuard;
+	std::thread ioThread;
+
+	// Only touched on the io thread
+	std::map<uint32_t, pendingRequest> pending;
+	std::vector<std::string> writeQueue;
+	std::vector<std::string> writing;
+	bool writeInProgress = false;
+	bool flushPosted = false;
+	char replyHeader[8];
+	std::string replyPayload;
+
+	std::atomic<uint32_t> nextId{ 1 };
+	std::atomic<std::size_t> inFlightCount{ 0 };
+	std::atomic<bool> scriptCancelled{ false };
+	std::atomic<bool> dead{ true };
+	bool closing = false;
+
+	mutable std::mutex errorMutex;
+	std::string deadError;
+
+	mutable std::mutex statsMutex;
+	std::map<std::string, rttHistogram> stats;
+};
+
+#endif// _RPCCHANNEL_H_
@@ -0,0 +1,445 @@
+/*
+Program: ESPFileXfer
+File: serialcapture.cpp
+Author: Listerine-debug
+Description: This file contains the implementation of segmented memory-mapped serial
+capture and the indexed capture search for ESPFileXfer.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+#include "serialcapture.h"
+#include "filesystem"
+#include "algorithm"
+#include "functional"
+#include "regex"
+#include "thread"
+#include "chrono"
+#include "cstring"
+
+static_assert(sizeof(segmentHeader) == 64, "segment header must stay 64 bytes");
+
+static const char segmentMagic[8] = { 'E', 'S', 'P', 'S', 'E', 'G', '0', '1' };
+static const uint64_t SEARCH_UNIT_SIZE = 8ull * 1024 * 1024;
+static const std::size_t MAX_MATCH_LINE = 512;
+
+static std::filesystem::path segmentPath(const std::string& directory, uint32_t segment, const char* extension)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "segment_%06u.%s", segment, extension);
+	return std::filesystem::path(directory) / name;
+}
+
+static uint64_t wallClockNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/* ------------------------------------------------------------------------------------------------------------------------------ */
+
+mappedFile::~mappedFile()
+{
+	close();
+}
+
+bool mappedFile::openRead(const std::wstring& path)
+{
+	fileHandle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize))
+	{
+		close();
+		return false;
+	}
+	viewSize = static_cast<uint64_t>(fileSize.QuadPart);
+	if (viewSize == 0) return true; // empty index, nothing to map
+
+	mappingHandle = CreateFileMappingW(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle != NULL)
+		view = static_cast<char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (view == nullptr)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool mappedFile::openWrite(const std::wstring& path, uint64_t size)
+{
+	fileHandle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE) return false;
+
+	mappingHandle = CreateFileMappingW(fileHandle, NULL, PAGE_READWRITE,
+		static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xFFFFFFFF), NULL);
+	if (mappingHandle != NULL)
+		view = static_cast<char*>(MapViewOfFile(mappingHandle, FILE_MAP_WRITE, 0, 0, 0));
+	if (view == nullptr)
+	{
+		close();
+		return false;
+	}
+	viewSize = size;
+	return true;
+}
+
+void mappedFile::close(uint64_t truncateTo)
+{
+	if (view)
+	{
+		UnmapViewOfFile(view);
+		view = nullptr;
+	}
+	if (mappingHandle != NULL)
+	{
+		CloseHandle(mappingHandle);
+		mappingHandle = NULL;
+	}
+	if (fileHandle != INVALID_HANDLE_VALUE)
+	{
+		// Give back the unused tail of a preallocated segment
+		if (truncateTo != UINT64_MAX)
+		{
+			LARGE_INTEGER position;
+			position.QuadPart = static_cast<LONGLONG>(truncateTo);
+			if (SetFilePointerEx(fileHandle, position, NULL, FILE_BEGIN))
+				SetEndOfFile(fileHandle);
+		}
+		CloseHandle(fileHandle);
+		fileHandle = INVALID_HANDLE_VALUE;
+	}
+	viewSize = 0;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------------------ */
+
+serialCaptureWriter::~serialCaptureWriter()
+{
+	close();
+}
+
+bool serialCaptureWriter::open(const std::string& directory)
+{
+	std::lock_guard<std::mutex> lock(writeMutex);
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error) return false;
+
+	// Continue after any segments already in the directory
+	captureDirectory = directory;
+	segmentNumber = 0;
+	while (std::filesystem::exists(segmentPath(captureDirectory, segmentNumber, "espseg")))
+		++segmentNumber;
+
+	totalBytes = 0;
+	if (!openSegment()) return false;
+	active = true;
+	return true;
+}
+
+void serialCaptureWriter::close()
+{
+	std::lock_guard<std::mutex> lock(writeMutex);
+	if (!active) return;
+	active = false;
+	closeSegment();
+}
+
+bool serialCaptureWriter::openSegment()
+{
+	if (!segment.openWrite(segmentPath(captureDirectory, segmentNumber, "espseg").wstring(), SEGMENT_SIZE))
+		return false;
+
+	indexFile.open(segmentPath(captureDirectory, segmentNumber, "espidx"), std::ios::binary | std::ios::trunc);
+	if (!indexFile)
+	{
+		segment.close(0);
+		return false;
+	}
+
+	header = reinterpret_cast<segmentHeader*>(segment.data());
+	std::memset(header, 0, sizeof(segmentHeader));
+	std::memcpy(header->magic, segmentMagic, sizeof(segmentMagic));
+
+	// Every segment starts with an index entry so it can be searched on its own
+	atLineStart = true;
+	return true;
+}
+
+void serialCaptureWriter::closeSegment()
+{
+	if (!header) return;
+
+	uint64_t used = sizeof(segmentHeader) + header->usedBytes;
+	FlushViewOfFile(segment.data(), static_cast<SIZE_T>(used));
+	header = nullptr;
+	segment.close(used);
+	indexFile.close();
+	++segmentNumber;
+}
+
+void serialCaptureWriter::indexLine(uint64_t timestampNs, uint64_t offset)
+{
+	lineIndexEntry entry{ timestampNs, offset };
+	indexFile.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+}
+
+void serialCaptureWriter::write(const char* data, std::size_t len)
+{
+	std::lock_guard<std::mutex> lock(writeMutex);
+	if (!active || len == 0) return;
+
+	uint64_t timestampNs = wallClockNs();
+	const uint64_t capacity = SEGMENT_SIZE - sizeof(segmentHeader);
+
+	while (len > 0)
+	{
+		if (header->usedBytes == capacity)
+		{
+			closeSegment();
+			if (!openSegment())
+			{
+				active = false;
+				return;
+			}
+		}
+
+		std::size_t chunk = static_cast<std::size_t>(std::min<uint64_t>(len, capacity - header->usedBytes));
+		std::memcpy(segment.data() + sizeof(segmentHeader) + header->usedBytes, data, chunk);
+
+		// Lines in one chunk share a timestamp, so only the first line start is indexed
+		const char* newline = static_cast<const char*>(std::memchr(data, '\n', chunk));
+		if (atLineStart)
+			indexLine(timestampNs, header->usedBytes);
+		else if (newline && newline + 1 < data + chunk)
+			indexLine(timestampNs, header->usedBytes + (newline - data) + 1);
+
+		atLineStart = (data[chunk - 1] == '\n');
+
+		if (header->firstTimestampNs == 0) header->firstTimestampNs = timestampNs;
+		header->lastTimestampNs = timestampNs;
+		header->usedBytes += chunk;
+		totalBytes += chunk;
+
+		data += chunk;
+		len -= chunk;
+	}
+	indexFile.flush();
+}
+
+/* ------------------------------------------------------------------------------------------------------------------------------ */
+
+bool serialCaptureReader::open(const std::string& directory)
+{
+	segments.clear();
+	for (uint32_t number = 0; ; ++number)
+	{
+		std::filesystem::path dataPath = segmentPath(directory, number, "espseg");
+		std::ifstream segmentFile(dataPath, std::ios::binary);
+		if (!segmentFile) break;
+
+		segmentHeader header;
+		if (!segmentFile.read(reinterpret_cast<char*>(&header), sizeof(header))) break;
+		if (std::memcmp(header.magic, segmentMagic, sizeof(segmentMagic)) != 0) break;
+
+		segmentFiles files;
+		files.dataPath = dataPath.wstring();
+		files.indexPath = segmentPath(directory, number, "espidx").wstring();
+		files.firstTimestampNs = header.firstTimestampNs;
+		files.lastTimestampNs = header.lastTimestampNs;
+		segments.push_back(files);
+	}
+	return !segments.empty();
+}
+
+uint64_t serialCaptureReader::firstTimestamp() const
+{
+	return segments.empty() ? 0 : segments.front().firstTimestampNs;
+}
+
+uint64_t serialCaptureReader::lastTimestamp() const
+{
+	return segments.empty() ? 0 : segments.back().lastTimestampNs;
+}
+
+std::shared_ptr<serialCaptureReader::segmentView> serialCaptureReader::mapSegment(uint32_t segment)
+{
+	auto view = std::make_shared<segmentView>();
+	if (!view->data.openRead(segments[segment].dataPath) || view->data.size() < sizeof(segmentHeader))
+		return nullptr;
+	if (!view->index.openRead(segments[segment].indexPath))
+		return nullptr;
+	return view;
+}
+
+bool serialCaptureReader::seekTime(uint64_t timestampNs, uint32_t& segment, uint64_t& offset)
+{
+	for (uint32_t number = 0; number < segments.size(); ++number)
+	{
+		if (segments[number].lastTimestampNs < timestampNs) continue;
+
+		auto view = mapSegment(number);
+		if (!view) return false;
+
+		const lineIndexEntry* begin = view->entries();
+		const lineIndexEntry* end = begin + view->entryCount();
+		const lineIndexEntry* entry = std::lower_bound(begin, end, timestampNs,
+			[](const lineIndexEntry& e, uint64_t ts) { return e.timestampNs < ts; });
+		if (entry == end) continue;
+
+		segment = number;
+		offset = entry->offset;
+		return true;
+	}
+	return false;
+}
+
+std::string serialCaptureReader::read(uint32_t segment, uint64_t offset, std::size_t len)
+{
+	if (segment >= segments.size()) return std::string();
+
+	auto view = mapSegment(segment);
+	if (!view || offset >= view->length()) return std::string();
+
+	len = static_cast<std::size_t>(std::min<uint64_t>(len, view->length() - offset));
+	return std::string(view->bytes() + offset, len);
+}
+
+std::vector<captureMatch> serialCaptureReader::search(const std::string& pattern, bool useRegex,
+	uint64_t fromNs, uint64_t toNs, std::size_t maxMatches)
+{
+	if (pattern.empty() || segments.empty()) return {};
+
+	// Compiled up front so a bad expression throws on the calling thread
+	std::regex expression;
+	if (useRegex)
+		expression = std::regex(pattern, std::regex::ECMAScript | std::regex::optimize);
+
+	struct workUnit
+	{
+		std::shared_ptr<segmentView> view;
+		uint32_t segment;
+		uint64_t begin;
+		uint64_t end;
+	};
+
+	// Narrow each segment to the requested time range with the index, then split it
+	// into line aligned units so large segments are shared between workers
+	std::vector<workUnit> units;
+	for (uint32_t number = 0; number < segments.size(); ++number)
+	{
+		if (segments[number].lastTimestampNs < fromNs || segments[number].firstTimestampNs > toNs) continue;
+
+		auto view = mapSegment(number);
+		if (!view) continue;
+
+		const lineIndexEntry* first = view->entries();
+		const lineIndexEntry* last = first + view->entryCount();
+		auto byTime = [](const lineIndexEntry& e, uint64_t ts) { return e.timestampNs < ts; };
+
+		const lineIndexEntry* from = std::lower_bound(first, last, fromNs, byTime);
+		const lineIndexEntry* to = (toNs == UINT64_MAX) ? last : std::lower_bound(from, last, toNs + 1, byTime);
+		uint64_t begin = (from == last) ? view->length() : from->offset;
+		uint64_t end = (to == last) ? view->length() : to->offset;
+
+		while (begin < end)
+		{
+			uint64_t split = std::min(end, begin + SEARCH_UNIT_SIZE);
+			if (split < end)
+			{
+				const char* newline = static_cast<const char*>(std::memchr(view->bytes() + split, '\n', static_cast<std::size_t>(end - split)));
+				split = newline ? (newline - view->bytes()) + 1 : end;
+			}
+			units.push_back({ view, number, begin, split });
+			begin = split;
+		}
+	}
+
+	std::vector<std::vector<captureMatch>> unitMatches(units.size());
+	std::atomic<std::size_t> nextUnit = 0;
+	std::atomic<std::size_t> matchCount = 0;
+
+	auto worker = [&]()
+		{
+			std::boyer_moore_horspool_searcher<std::string::const_iterator> searcher(pattern.begin(), pattern.end());
+
+			for (std::size_t u = nextUnit++; u < units.size(); u = nextUnit++)
+			{
+				// Units are claimed in capture order, so every earlier unit is already being searched
+				if (matchCount >= maxMatches) break;
+
+				const workUnit& unit = units[u];
+				const char* bytes = unit.view->bytes();
+				const lineIndexEntry* entries = unit.view->entries();
+				const lineIndexEntry* entriesEnd = entries + unit.view->entryCount();
+				std::vector<captureMatch>& found = unitMatches[u];
+
+				auto addLine = [&](uint64_t lineStart, uint64_t lineEnd)
+					{
+						const lineIndexEntry* entry = std::upper_bound(entries, entriesEnd, lineStart,
+							[](uint64_t offset, const lineIndexEntry& e) { return offset < e.offset; });
+
+						captureMatch match;
+						match.segment = unit.segment;
+						match.offset = lineStart;
+						match.timestampNs = (entry == entries) ? segments[unit.segment].firstTimestampNs : (entry - 1)->timestampNs;
+						std::size_t lineLength = static_cast<std::size_t>(std::min<uint64_t>(lineEnd - lineStart, MAX_MATCH_LINE));
+						match.line.assign(bytes + lineStart, lineLength);
+						while (!match.line.empty() && (match.line.back() == '\r' || match.line.back() == '\n'))
+							match.line.pop_back();
+						found.push_back(std::move(match));
+						++matchCount;
+					};
+
+				uint64_t position = unit.begin;
+				while (position < unit.end && found.size() < maxMatches)
+				{
+					uint64_t lineStart = position;
+					if (useRegex)
+					{
+						const char* newline = static_cast<const char*>(std::memchr(bytes + position, '\n', static_cast<std::size_t>(unit.end - position)));
+						uint64_t lineEnd = newline ? (newline - bytes) + 1 : unit.end;
+						uint64_t contentEnd = lineEnd;
+						while (contentEnd > lineStart && (bytes[contentEnd - 1] == '\n' || bytes[contentEnd - 1] == '\r')) --contentEnd;
+						if (std::regex_search(bytes + lineStart, bytes + contentEnd, expression))
+							addLine(lineStart, lineEnd);
+						position = lineEnd;
+					}
+					else
+					{
+						const char* hit = std::search(bytes + position, bytes + unit.end, searcher);
+						if (hit == bytes + unit.end) break;
+
+						const char* lineBegin = hit;
+						while (lineBegin > bytes + unit.begin && lineBegin[-1] != '\n') --lineBegin;
+						const char* newline = static_cast<const char*>(std::memchr(hit, '\n', static_cast<std::size_t>(bytes + unit.end - hit)));
+						uint64_t lineEnd = newline ? (newline - bytes) + 1 : unit.end;
+						addLine(lineBegin - bytes, lineEnd);
+						position = lineEnd;
+					}
+				}
+			}
+		};
+
+	unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<std::thread> workers;
+	for (unsigned i = 1; i < threadCount; ++i)
+		workers.emplace_back(worker);
+	worker();
+	for (auto& thread : workers)
+		thread.join();
+
+	std::vector<captureMatch> matches;
+	for (auto& found : unitMatches)
+	{
+		for (auto& match : found)
+		{
+			if (matches.size() >= maxMatches) return matches;
+			matches.push_back(std::move(match));
+		}
+	}
+	return matches;
+}
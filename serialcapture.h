@@ -0,0 +1,148 @@
+/*
+Program: ESPFileXfer
+File: serialcapture.h
+Author: Listerine-debug
+Description: This file contains the declarations for lossless long running serial capture
+into segmented memory-mapped files, with a per-line timestamp index used for time-range
+seeks and multi-threaded substring/regex search.
+License: Unlicense
+Date of Last Implementation: 2026-10-19 , YYYY-MM-DD
+*/
+
+
+#ifndef _SERIALCAPTURE_H_
+#define _SERIALCAPTURE_H_
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include "Windows.h"
+#include "string"
+#include "vector"
+#include "fstream"
+#include "mutex"
+#include "atomic"
+#include "memory"
+#include "cstdint"
+
+// A capture is a directory of numbered segments:
+//   segment_000000.espseg : 64 byte header followed by raw serial bytes
+//   segment_000000.espidx : one lineIndexEntry per received chunk, pointing at the
+//                           first line that starts in it (lines in a chunk share its timestamp)
+// The segment header is kept up to date in the mapping, so a capture stays
+// readable even if the application is killed mid session.
+struct segmentHeader
+{
+	char magic[8];				// "ESPSEG01"
+	uint64_t usedBytes;			// data bytes after the header
+	uint64_t firstTimestampNs;	// ns since epoch
+	uint64_t lastTimestampNs;
+	uint8_t reserved[32];
+};
+
+struct lineIndexEntry
+{
+	uint64_t timestampNs;	// ns since epoch
+	uint64_t offset;		// data offset within the segment
+};
+
+struct captureMatch
+{
+	uint32_t segment = 0;
+	uint64_t offset = 0;
+	uint64_t timestampNs = 0;
+	std::string line;
+};
+
+// Read-only or read-write view of a whole file
+class mappedFile
+{
+public:
+	~mappedFile();
+	bool openRead(const std::wstring& path);
+	bool openWrite(const std::wstring& path, uint64_t size);
+	void close(uint64_t truncateTo = UINT64_MAX);
+	char* data() const { return view; }
+	uint64_t size() const { return viewSize; }
+
+private:
+	HANDLE fileHandle = INVALID_HANDLE_VALUE;
+	HANDLE mappingHandle = NULL;
+	char* view = nullptr;
+	uint64_t viewSize = 0;
+};
+
+class serialCaptureWriter
+{
+public:
+	~serialCaptureWriter();
+	bool open(const std::string& directory);
+	void close();
+	bool isOpen() const { return active; }
+	uint64_t bytesWritten() const { return totalBytes; }
+
+	// Safe to call from the asio thread, copies straight into the mapped segment
+	void write(const char* data, std::size_t len);
+
+	static const uint64_t SEGMENT_SIZE = 64ull * 1024 * 1024;
+
+private:
+	bool openSegment();
+	void closeSegment();
+	void indexLine(uint64_t timestampNs, uint64_t offset);
+
+	std::mutex writeMutex;
+	std::string captureDirectory;
+	uint32_t segmentNumber = 0;
+	mappedFile segment;
+	segmentHeader* header = nullptr;
+	std::ofstream indexFile;
+	bool atLineStart = true;
+	std::atomic<bool> active = false;
+	std::atomic<uint64_t> totalBytes = 0;
+};
+
+class serialCaptureReader
+{
+public:
+	bool open(const std::string& directory);
+	uint32_t segmentCount() const { return static_cast<uint32_t>(segments.size()); }
+	uint64_t firstTimestamp() const;
+	uint64_t lastTimestamp() const;
+
+	// Finds the first line stamped at or after timestampNs
+	bool seekTime(uint64_t timestampNs, uint32_t& segment, uint64_t& offset);
+
+	// Reads up to len bytes starting at a segment offset, without mapping the rest of the capture
+	std::string read(uint32_t segment, uint64_t offset, std::size_t len);
+
+	// Searches [fromNs, toNs] across all segments using one worker per core.
+	// Matches are reported once per line, in capture order.
+	std::vector<captureMatch> search(const std::string& pattern, bool useRegex,
+		uint64_t fromNs, uint64_t toNs, std::size_t maxMatches);
+
+private:
+	struct segmentFiles
+	{
+		std::wstring dataPath;
+		std::wstring indexPath;
+		uint64_t firstTimestampNs = 0;
+		uint64_t lastTimestampNs = 0;
+	};
+
+	struct segmentView
+	{
+		mappedFile data;
+		mappedFile index;
+		const char* bytes() const { return data.data() + sizeof(segmentHeader); }
+		uint64_t length() const { return reinterpret_cast<const segmentHeader*>(data.data())->usedBytes; }
+		const lineIndexEntry* entries() const { return reinterpret_cast<const lineIndexEntry*>(index.data()); }
+		uint64_t entryCount() const { return index.size() / sizeof(lineIndexEntry); }
+	};
+
+	std::shared_ptr<segmentView> mapSegment(uint32_t segment);
+
+	std::vector<segmentFiles> segments;
+};
+
+#endif// _SERIALCAPTURE_H_